@@ -0,0 +1,186 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Declares SpscRing and AsyncWriter: moves debug and trace output off the
+// simulation thread. The simulation thread pushes fixed-size records into a
+// lock-free single-producer/single-consumer ring; a writer thread formats
+// them into a large buffer and hands it to the sink in big batches.
+
+// What push() does when the ring is full
+enum class LogPolicy {
+    BLOCK,   // Wait for the writer (lossless, the default)
+    DROP     // Discard the record and count it
+};
+
+// Bounded ring for exactly one producer and one consumer thread. Each side
+// keeps a private copy of the other side's index and only reloads it when the
+// ring looks full (or empty), so the shared cache lines are rarely touched.
+template <typename T>
+class SpscRing {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head;   // Next slot to pop (consumer)
+    size_t cachedTail;                      // Consumer's view of tail
+    alignas(64) std::atomic<size_t> tail;   // Next slot to push (producer)
+    size_t cachedHead;                      // Producer's view of head
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) : head(0), cachedTail(0), tail(0), cachedHead(0) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool push(const T& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == slots.size()) {
+                return false;
+            }
+        }
+        slots[t & mask] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+        value = slots[h & mask];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+// Formats Records on a background thread. format appends the text (or bytes)
+// of one record to the batch; sink receives each finished batch, always on
+// the writer thread.
+template <typename Record>
+class AsyncWriter {
+public:
+    typedef std::function<void(const Record&, std::string&)> Formatter;
+    typedef std::function<void(const char*, size_t)> Sink;
+
+    static constexpr size_t DEFAULT_CAPACITY = 8192;   // Records
+    static constexpr size_t BATCH_BYTES = 256 * 1024;  // Sink call size under load
+
+private:
+    SpscRing<Record> ring;
+    LogPolicy policy;
+    Formatter format;
+    Sink sink;
+    size_t pushed;                  // Producer only
+    size_t dropped;                 // Producer only
+    std::atomic<size_t> written;    // Records formatted and handed to the sink
+    std::atomic<bool> stopping;
+    std::thread worker;
+
+    void run() {
+        std::string batch;
+        batch.reserve(BATCH_BYTES + 4096);
+        Record record;
+        size_t batched = 0;
+        int idle = 0;
+
+        for (;;) {
+            if (ring.pop(record)) {
+                format(record, batch);
+                batched++;
+                idle = 0;
+                if (batch.size() >= BATCH_BYTES) {
+                    emit(batch, batched);
+                }
+                continue;
+            }
+
+            // Ring drained: hand over what there is, then wait for more
+            if (batched > 0) {
+                emit(batch, batched);
+            }
+            if (stopping.load(std::memory_order_acquire)) {
+                if (ring.empty()) break;
+                continue;
+            }
+            if (++idle < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    void emit(std::string& batch, size_t& batched) {
+        if (!batch.empty()) {
+            sink(batch.data(), batch.size());
+            batch.clear();
+        }
+        written.fetch_add(batched, std::memory_order_release);
+        batched = 0;
+    }
+
+public:
+    AsyncWriter(Formatter format, Sink sink, LogPolicy policy = LogPolicy::BLOCK,
+                size_t capacity = DEFAULT_CAPACITY)
+        : ring(capacity), policy(policy), format(format), sink(sink), pushed(0), dropped(0),
+          written(0), stopping(false) {
+        worker = std::thread(&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter() { close(); }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Queue one record; false if it was dropped
+    bool push(const Record& record) {
+        while (!ring.push(record)) {
+            if (policy == LogPolicy::DROP) {
+                dropped++;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        pushed++;
+        return true;
+    }
+
+    // Wait until every queued record has reached the sink
+    void flush() {
+        while (written.load(std::memory_order_acquire) != pushed) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Flush and stop the writer thread
+    void close() {
+        if (worker.joinable()) {
+            stopping.store(true, std::memory_order_release);
+            worker.join();
+        }
+    }
+
+    size_t droppedCount() const { return dropped; }
+};
+
+#endif // ASYNCWRITER_H
@@ -0,0 +1,67 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "cpu.h"
+#include "binloader.h"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Declares BatchRunner: runs many assembly programs on a work-stealing thread
+// pool, each with its own Parser, ErrorHandler and CPU, and writes one JSON
+// record per program (JSON Lines, in input order)
+
+struct BatchOptions {
+    ExecMode mode;
+    PipelineConfig config;
+    MemoryBackend backend;
+    size_t jobs;            // Worker threads, 0 = one per hardware thread
+    size_t maxCycles;       // Per-program cycle limit, 0 = CPU default
+    bool flatBinary;        // Inputs that are not object or ELF files are raw code
+    ByteOrder byteOrder;
+    bool ignoreDelaySlots;  // Accept machine code with real work in delay slots
+
+    BatchOptions()
+        : mode(ExecMode::PIPELINE), backend(MemoryBackend::PAGED), jobs(0), maxCycles(0),
+          flatBinary(false), byteOrder(ByteOrder::BIG), ignoreDelaySlots(false) {}
+};
+
+// Outcome of one program
+struct BatchResult {
+    std::string file;
+    std::string status;       // ok, cycle-limit, parse-error, runtime-error, io-error
+    std::string error;        // First diagnostic when status is an error
+    size_t instructions;      // Static instruction count
+    size_t cycles;
+    size_t retired;
+    std::array<int32_t, 32> registers;
+    uint64_t memoryHash;      // FNV-1a over non-zero memory pages
+    double millis;            // Host wall time for parse + run
+
+    BatchResult() : instructions(0), cycles(0), retired(0), memoryHash(0), millis(0) {
+        registers.fill(0);
+    }
+};
+
+class BatchRunner {
+public:
+    // Expand glob patterns and read list files ("-" for stdin) into paths
+    static std::vector<std::string> collect(const std::vector<std::string>& patterns,
+                                            const std::vector<std::string>& listFiles);
+
+    // Parse and run one program without printing anything
+    static BatchResult runOne(const std::string& file, const BatchOptions& options);
+
+    // Run every program and write its record to out as soon as all earlier
+    // records are written. Returns the number of programs that failed.
+    static size_t run(const std::vector<std::string>& files, const BatchOptions& options,
+                      std::ostream& out);
+
+    static void writeRecord(std::ostream& out, const BatchResult& result);
+
+    static uint64_t memoryHash(const GuestMemory& memory);
+};
+
+#endif // BATCH_H
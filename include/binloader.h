@@ -0,0 +1,42 @@
+#ifndef BINLOADER_H
+#define BINLOADER_H
+
+#include "cpu.h"
+#include "mappedfile.h"
+#include <cstdint>
+
+// Declares BinaryLoader: builds a Program from MIPS32 machine code instead of
+// assembly text. Two containers are understood:
+//
+//   flat - raw instruction words from byte 0, in the byte order given
+//   ELF  - ELF32 with e_machine EM_MIPS, either byte order (from EI_DATA).
+//          .text is decoded into instructions; other allocated PROGBITS
+//          sections become initial data segments at their sh_addr.
+//
+// Every word of .text must decode (see MachineCode::decode); anything else is
+// rejected with the offending word and address.
+//
+// Branch delay slots are not modelled: a taken branch or jump skips the
+// instruction after it. Code where every branch and jump is followed by a NOP
+// behaves the same either way and loads as is; anything else is rejected
+// unless ignoreDelaySlots is set (--no-delay-slots).
+
+enum class ByteOrder { LITTLE, BIG };
+
+class BinaryLoader {
+public:
+    // True if the file starts with the ELF magic
+    static bool isElf(const MappedFile& file);
+
+    // Throw runtime_error on malformed input or unsupported instructions
+    static Program loadFlat(const MappedFile& file, ByteOrder order, uint32_t base = 0);
+    static Program loadElf(const MappedFile& file);
+
+    // Load any non-assembly input: an object file, an ELF file, or (when flat
+    // is set) a raw binary. Returns false if the file is assembly source.
+    // Object files come from the assembler and skip the delay slot check.
+    static bool loadPrebuilt(const MappedFile& file, bool flat, ByteOrder order, Program& program,
+                             bool ignoreDelaySlots = false);
+};
+
+#endif // BINLOADER_H
@@ -0,0 +1,67 @@
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include "cpu.h"
+#include <deque>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+// Declares BasicBlock and the BlockCache class that splits a program into
+// basic blocks at BEQ/J boundaries. Micro-ops and superinstructions are built
+// for the whole program up front, as threaded mode does; a BasicBlock record
+// is made on first use and only points into that array.
+
+// A straight-line run of micro-ops ending at a branch, a jump or a block leader
+struct BasicBlock {
+    size_t start;                // First instruction index
+    size_t length;               // Number of instructions covered
+    const MicroOp* ops;          // Fused micro-ops of the whole program, indexed by pc
+    size_t last;                 // pc of the final micro-op, the only one that may branch
+    BasicBlock* successors[2];   // Fall-through and taken successors, once looked up
+    size_t hits;                 // Times executed (JIT hotness)
+    const void* native;          // Compiled entry (see JitCompiler::run), or nullptr
+    
+    BasicBlock() : start(0), length(0), ops(nullptr), last(0),
+                   successors{nullptr, nullptr}, hits(0), native(nullptr) {}
+};
+
+class BlockCache {
+private:
+    std::vector<MicroOp> microOps;    // One micro-op per instruction
+    std::vector<MicroOp> fusedOps;    // microOps with superinstructions fused in
+    std::vector<uint32_t> blockEnd;   // Instruction index -> end of the block holding it
+    std::vector<int32_t> blockIndex;  // Instruction index -> block, -1 if not yet made
+    std::deque<BasicBlock> blocks;    // Never moves, so successor links stay valid
+    
+    BasicBlock buildBlock(size_t start) const;
+    
+public:
+    BlockCache(const std::vector<Instruction>& instructions);
+    
+    // Get the block starting at pc, making it on first use
+    BasicBlock& lookup(size_t pc);
+    
+    // The block to run after block when it ended with next pc pc (not past
+    // the end of the program), linked on first use so the steady state does
+    // no lookup
+    BasicBlock& successor(BasicBlock& block, size_t pc) {
+        // Indexed rather than branched on, as data-dependent branches mispredict
+        BasicBlock*& link = block.successors[pc != block.start + block.length];
+        if (!link) link = &lookup(pc);
+        return *link;
+    }
+    
+    // Execute a whole block, returns the next pc
+    static size_t execute(
+        const BasicBlock& block,
+        std::array<int32_t, 32>& registers,
+        GuestMemory& memory
+    );
+    
+    size_t programSize() const { return microOps.size(); }
+    size_t blockCount() const { return blocks.size(); }
+    const std::vector<MicroOp>& getMicroOps() const { return microOps; }
+};
+
+#endif // BLOCKCACHE_H
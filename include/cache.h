@@ -0,0 +1,62 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "cpu.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Declares the Cache class: a set-associative, tag-only timing model placed in
+// front of guest memory. Data always lives in CPU memory; the cache only decides
+// how many cycles an access costs.
+
+struct CacheStats {
+    size_t reads;
+    size_t writes;
+    size_t hits;
+    size_t misses;
+    size_t writebacks;   // Dirty lines evicted (write-back only)
+    
+    CacheStats() : reads(0), writes(0), hits(0), misses(0), writebacks(0) {}
+};
+
+class Cache {
+private:
+    struct Line {
+        bool valid;
+        bool dirty;
+        uint32_t tag;
+        uint64_t stamp;   // Last use (LRU) or fill time (FIFO)
+        
+        Line() : valid(false), dirty(false), tag(0), stamp(0) {}
+    };
+    
+    CacheConfig config;
+    std::vector<Line> lines;   // sets * ways, set-major
+    size_t sets;
+    unsigned offsetBits;
+    unsigned indexBits;
+    uint64_t clock;            // Access counter for LRU/FIFO stamps
+    uint32_t rng;              // xorshift state for RANDOM replacement
+    CacheStats stats;
+    
+    size_t chooseVictim(size_t base);
+    
+public:
+    Cache(const CacheConfig& cfg);
+    
+    // Look up one access, returns the stall cycles it costs (0 on a hit)
+    size_t access(uint32_t address, bool write);
+    
+    const CacheConfig& getConfig() const { return config; }
+    const CacheStats& getStats() const { return stats; }
+};
+
+// Parse SIZE:LINE:WAYS[:lru|fifo|random[:wb|wt[:LATENCY]]] (sizes in bytes)
+// Returns false for malformed or inconsistent geometry
+bool parseCacheConfig(const std::string& spec, CacheConfig& cfg);
+
+// Short description, e.g. "4096B 32B/line 2-way lru wb 10cy"
+std::string cacheConfigToString(const CacheConfig& cfg);
+
+#endif // CACHE_H
@@ -0,0 +1,42 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "cpu.h"
+#include <cstdint>
+
+// Declares the on-disk layout written by CPU::saveCheckpoint and read by
+// CPU::loadCheckpoint. All fields are in host byte order:
+//
+//   CheckpointHeader
+//   IF_ID, ID_EX, EX_MEM, MEM_WB      raw latch images (sizes in the header)
+//   uint32_t pageNumbers[pageCount]   ascending
+//   zero padding up to dataOffset     (a multiple of GuestMemory::PAGE_SIZE)
+//   page data, PAGE_SIZE bytes each   in pageNumbers order
+//
+// Page data is page aligned so a restore can mmap it instead of copying.
+// Cache, predictor and statistics state are not saved: a restored run starts
+// with cold caches and predictors and counts stalls from the restore point.
+
+static const char CHECKPOINT_MAGIC[8] = {'M', 'I', 'P', 'S', 'C', 'K', 'P', 'T'};
+static const uint32_t CHECKPOINT_VERSION = 1;
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;              // ExecMode of the CPU that saved it
+    uint64_t programHash;       // checkpointProgramHash() of the program
+    uint32_t programSize;       // Instruction count
+    uint32_t pageCount;         // Dirty pages stored
+    uint64_t dataOffset;        // File offset of the first page
+    uint64_t pc;
+    uint64_t cycleCount;
+    uint64_t instructionCount;
+    int32_t registers[32];
+    uint32_t latchSizes[4];     // sizeof IF_ID, ID_EX, EX_MEM, MEM_WB
+};
+
+// FNV-1a over the decoded instructions, so a checkpoint is only restored into
+// the program it was taken from
+uint64_t checkpointProgramHash(const std::vector<Instruction>& instructions);
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,27 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include "cpu.h"
+#include <ostream>
+#include <string>
+
+// Declares Counters: writes the simulated performance counters (PerfCounters,
+// see cpu.h) as one JSON object or as counter,value CSV rows. Without
+// PerfCounters::instructionMix the opcode, load, store and branch fields are
+// null in JSON and have an empty value in CSV.
+
+class Counters {
+public:
+    // Parse "json" or "csv"; false for anything else
+    static bool parseFormat(const std::string& text, CounterFormat& format);
+
+    static void writeJson(std::ostream& out, const PerfCounters& counters, ExecMode mode);
+    static void writeCsv(std::ostream& out, const PerfCounters& counters, ExecMode mode);
+
+    // Write in the given format to path, or to stdout if path is empty;
+    // throws runtime_error if the file cannot be written
+    static void report(const PerfCounters& counters, ExecMode mode, CounterFormat format,
+                       const std::string& path);
+};
+
+#endif // COUNTERS_H
@@ -6,6 +6,10 @@
 #include <cstdint>
 #include <array>
 #include <unordered_map>
+#include <type_traits>
+#include <memory>
+#include "guestmem.h"
+#include "asyncwriter.h"
 
 // Defines all core data structures: 
 // Instruction, Opcode, ControlSignals, pipeline registers (IF_ID, ID_EX, EX_MEM, MEM_WB), 
@@ -19,7 +23,133 @@ enum class Opcode {
     UNKNOWN
 };
 
+// Simulation engine selected with --mode
+enum class ExecMode {
+    PIPELINE,    // Cycle-level 5-stage pipeline model
+    FUNCTIONAL,  // One instruction per step, no pipeline registers
+    THREADED,    // Functional, dispatched through pre-decoded micro-ops
+    BLOCK,       // Functional, one basic block (with superinstructions) per dispatch
+    JIT          // Block mode with hot blocks compiled to native x86-64 code
+};
+
+// Branch predictor consulted at fetch (see predictor.h)
+enum class PredictorType {
+    NOT_TAKEN,   // Always fetch the fall-through path
+    BTFN,        // Backward taken, forward not taken
+    ONE_BIT,     // Last outcome per PC
+    TWO_BIT,     // 2-bit saturating counter per PC
+    GSHARE,      // 2-bit counters indexed by PC xor global history
+    BTB          // Branch target buffer with 2-bit counters
+};
+
+// Cache replacement and write policies (see cache.h)
+enum class ReplacementPolicy { LRU, FIFO, RANDOM };
+enum class WritePolicy {
+    WRITE_BACK,     // Write-allocate, dirty lines written on eviction
+    WRITE_THROUGH   // No write-allocate, every store goes to memory
+};
+
+// Geometry and timing of one cache level
+struct CacheConfig {
+    bool enabled;
+    size_t size;            // Total bytes
+    size_t lineSize;        // Bytes per line
+    size_t associativity;   // Ways per set
+    ReplacementPolicy replacement;
+    WritePolicy writePolicy;
+    size_t missLatency;     // Stall cycles per miss
+    
+    CacheConfig() : enabled(false), size(4096), lineSize(32), associativity(2),
+                    replacement(ReplacementPolicy::LRU),
+                    writePolicy(WritePolicy::WRITE_BACK), missLatency(10) {}
+};
+
+// Pipeline options selectable at runtime
+struct PipelineConfig {
+    bool forwarding;         // EX/MEM->EX and MEM/WB->EX bypass paths
+    bool hazardDetection;    // Stall on RAW hazards the bypass paths cannot cover
+    PredictorType predictor;
+    size_t predictorSize;    // Predictor table entries (power of two)
+    bool reportStats;        // Print CPI, stall and branch statistics at the end of run()
+    CacheConfig icache;      // Instruction fetch timing
+    CacheConfig dcache;      // LW/SW timing
+    
+    PipelineConfig() : forwarding(false), hazardDetection(false),
+                       predictor(PredictorType::NOT_TAKEN), predictorSize(1024),
+                       reportStats(false) {}
+};
+
+// Why the hazard detection unit stalled the front end
+enum class StallCause {
+    NONE,
+    LOAD_USE,     // Load followed by a dependent instruction (forwarding on)
+    DATA_HAZARD   // Any RAW dependency still in flight (forwarding off)
+};
+
+// Lost cycles by cause
+struct StallStats {
+    size_t loadUse;      // Bubbles inserted for load-use hazards
+    size_t dataHazard;   // Bubbles inserted for RAW hazards without forwarding
+    size_t flushes;      // Mispredicted branches/jumps that flushed IF/ID and ID/EX
+    size_t icacheMiss;   // Fetch bubbles while waiting on the instruction cache
+    size_t dcacheMiss;   // Cycles the whole pipeline froze on the data cache
+    
+    StallStats() : loadUse(0), dataHazard(0), flushes(0), icacheMiss(0), dcacheMiss(0) {}
+};
+
+// Outcome counts for one branch/jump PC
+struct BranchStats {
+    size_t executed;
+    size_t taken;
+    size_t mispredicted;
+    
+    BranchStats() : executed(0), taken(0), mispredicted(0) {}
+};
+
+static const size_t OPCODE_COUNT = static_cast<size_t>(Opcode::UNKNOWN) + 1;
+
+// Simulated performance counters (see counters.h). The stage functions and
+// stepFunctional() count events; CPU::getCounters() adds the totals the CPU
+// keeps anyway (cycles, retired instructions, stalls and flushes). The
+// threaded, block and jit engines only report cycles and retired instructions;
+// for them instructionMix is false and the opcode, load, store and branch
+// counts are not collected (they read 0, they are not measured as 0).
+struct PerfCounters {
+    uint64_t cycles;
+    uint64_t retired;
+    std::array<uint64_t, OPCODE_COUNT> opcodes;  // Retired instructions by Opcode
+    uint64_t loads;
+    uint64_t stores;
+    uint64_t branchesTaken;     // BEQ
+    uint64_t branchesNotTaken;
+    uint64_t jumps;
+    uint64_t flushes;
+    uint64_t loadUseStalls;
+    uint64_t dataHazardStalls;
+    uint64_t icacheStalls;
+    uint64_t dcacheStalls;
+    uint64_t bubbles;           // Pipeline cycles in which WB retired nothing
+    bool instructionMix;        // opcodes, loads, stores and branches were counted
+    
+    PerfCounters() : cycles(0), retired(0), opcodes(), loads(0), stores(0), branchesTaken(0),
+                     branchesNotTaken(0), jumps(0), flushes(0), loadUseStalls(0),
+                     dataHazardStalls(0), icacheStalls(0), dcacheStalls(0), bubbles(0),
+                     instructionMix(false) {}
+    
+    double cpi() const { return retired ? double(cycles) / retired : 0.0; }
+};
+
+// How run() reports the counters
+enum class CounterFormat { NONE, JSON, CSV };
+
+// How run() reports the final state: formatted tables, or one
+// machine-readable document (see report.h)
+enum class OutputFormat { TEXT, JSON, CSV, BINARY };
+
 // Parsed instruction
+// Kept trivially copyable so the pipeline registers can carry it by value
+// every cycle without touching the heap. The source text lives in
+// Program::source, indexed by PC.
 struct Instruction {
     Opcode op;
     int rs;         // Source register 1
@@ -28,11 +158,47 @@ struct Instruction {
     int shamt;      // Shift amount
     int32_t imm;    // Immediate value
     size_t target;  // Jump/branch target (instruction index)
-    std::string text;  // Original text for debug
     
     Instruction() : op(Opcode::NOP), rs(0), rt(0), rd(0), shamt(0), imm(0), target(0) {}
 };
 
+struct MicroOp;
+
+// A handler executes one micro-op against the architectural state
+// Returns the index of the next micro-op to run
+typedef size_t (*MicroOpHandler)(
+    const MicroOp& uop,
+    size_t pc,
+    std::array<int32_t, 32>& registers,
+    GuestMemory& memory
+);
+
+// Pre-decoded instruction
+// Operands are resolved once at load time: the destination register is already
+// selected (rd or rt), the immediate is already sign extended and shift amounts
+// are already masked, so handlers do no decoding at all.
+struct MicroOp {
+    MicroOpHandler handler;
+    uint8_t dest;    // Destination register
+    uint8_t rs;      // Source register 1
+    uint8_t rt;      // Source register 2
+    uint8_t width;   // Instruction slots covered (2 for a fused superinstruction)
+    Opcode op;       // Original opcode (for debug and block building)
+    int32_t imm;     // Sign-extended immediate, or masked shift amount
+    size_t target;   // Jump/branch target (instruction index)
+    
+    MicroOp() : handler(nullptr), dest(0), rs(0), rt(0), width(1), op(Opcode::NOP), imm(0), target(0) {}
+};
+
+// Debug metadata for one instruction (side table, indexed by PC)
+struct SourceLine {
+    std::string text;  // Original text for debug
+    int line;          // Line number in the .asm file
+    
+    SourceLine() : line(0) {}
+    SourceLine(const std::string& t, int ln) : text(t), line(ln) {}
+};
+
 // Control signals generated during decode
 struct ControlSignals {
     bool regDst;    // 1=rd (R-type), 0=rt (I-type)
@@ -54,8 +220,10 @@ struct IF_ID {
     bool valid;
     size_t pc;
     Instruction instr;
+    size_t predictedPc;  // Next PC chosen at fetch by the branch predictor
+    size_t predictorIndex; // Predictor entry that chose it, trained in EX
     
-    IF_ID() : valid(false), pc(0) {}
+    IF_ID() : valid(false), pc(0), predictedPc(0), predictorIndex(0) {}
 };
 
 // ID/EX pipeline register
@@ -68,8 +236,11 @@ struct ID_EX {
     int32_t rtVal;      // Value read from rt
     int32_t signExtImm; // Sign-extended immediate
     int destReg;        // Destination register number
+    size_t predictedPc; // Next PC chosen at fetch, checked in EX
+    size_t predictorIndex;
     
-    ID_EX() : valid(false), pc(0), rsVal(0), rtVal(0), signExtImm(0), destReg(0) {}
+    ID_EX() : valid(false), pc(0), rsVal(0), rtVal(0), signExtImm(0), destReg(0),
+              predictedPc(0), predictorIndex(0) {}
 };
 
 // EX/MEM pipeline register
@@ -101,22 +272,69 @@ struct MEM_WB {
     MEM_WB() : valid(false), pc(0), aluResult(0), memReadData(0), destReg(0) {}
 };
 
-// Program loaded from assembly file
+static_assert(std::is_trivially_copyable<IF_ID>::value, "IF_ID must stay trivially copyable");
+static_assert(std::is_trivially_copyable<ID_EX>::value, "ID_EX must stay trivially copyable");
+static_assert(std::is_trivially_copyable<EX_MEM>::value, "EX_MEM must stay trivially copyable");
+static_assert(std::is_trivially_copyable<MEM_WB>::value, "MEM_WB must stay trivially copyable");
+
+// Initial guest memory contents (programs loaded from binaries)
+struct MemorySegment {
+    uint32_t address;             // Byte address of words[0], word aligned
+    std::vector<int32_t> words;
+    
+    MemorySegment() : address(0) {}
+};
+
+// Program loaded from an assembly, object, ELF or flat binary file
 struct Program {
     std::vector<Instruction> instructions;
+    std::vector<SourceLine> source;  // Parallel to instructions
     std::unordered_map<std::string, size_t> labels;
+    std::vector<MemorySegment> data;  // Stored into guest memory by the CPU constructor
+    size_t entry;                     // Index of the first instruction to fetch
+    
+    Program() : entry(0) {}
 };
 
+class BlockCache;
+class JitCompiler;
+class BranchPredictor;
+class Cache;
+class TraceWriter;
+class Profiler;
+class HostStats;
+class ExecHooks;
+struct DebugSnapshot;
+struct TraceRecord;
+
+// Caller's stop condition for CPU::advanceUntil, checked before every step
+typedef bool (*StopCheck)(void* context);
+
 // The CPU class that runs the simulation
 class CPU {
 private:
-    // Program
-    std::vector<Instruction> instructions;
+    // Program, shared read-only by every CPU built from the same pointer;
+    // instructions and source refer into it
+    std::shared_ptr<const Program> program;
+    const std::vector<Instruction>& instructions;
+    const std::vector<SourceLine>& source;
+    std::vector<MicroOp> microOps;  // Threaded code (THREADED mode only)
+    std::unique_ptr<BlockCache> blockCache;  // Translated blocks (BLOCK and JIT modes)
+    std::unique_ptr<JitCompiler> jit;        // Native code for hot blocks (JIT mode only)
+    std::unique_ptr<BranchPredictor> predictor;  // PIPELINE mode only
+    std::unique_ptr<Cache> icache;               // PIPELINE mode, when enabled
+    std::unique_ptr<Cache> dcache;
+    
+    // Outstanding cache miss latency
+    size_t fetchStallRemaining;
+    size_t memStallRemaining;
+    bool fetchCharged;   // Current fetch PC already looked up in the I-cache
+    bool memCharged;     // Current EX/MEM access already looked up in the D-cache
     
     // Architectural state
     size_t pc;
     std::array<int32_t, 32> registers;
-    std::vector<int32_t> memory;
+    GuestMemory memory;
     
     // Pipeline registers
     IF_ID if_id;
@@ -126,24 +344,126 @@ private:
     
     // Statistics
     size_t cycleCount;
+    size_t instructionCount;
+    StallStats stalls;
+    std::vector<BranchStats> branchStats;  // Indexed by PC
+    PerfCounters counters;   // Event counts; see getCounters() for the totals
+    CounterFormat counterFormat;
+    std::string counterPath; // run() writes the counters here, or to stdout
+    OutputFormat outputFormat;
     bool debugMode;
+    ExecMode mode;
+    PipelineConfig config;
+    size_t cycleLimit;       // run() and execute() stop here
+    TraceWriter* tracer;     // Binary trace output, or nullptr
+    Profiler* profiler;      // Per-PC cost accounting, or nullptr
+    HostStats* hostStats;    // Simulator self-timing in run(), or nullptr
+    ExecHooks* hooks;        // Embedder callbacks (see hooks.h), or nullptr
+    LogPolicy logPolicy;     // Debug output queue (see asyncwriter.h)
+    size_t logCapacity;
     
     // Helper methods
     ControlSignals generateControl(const Instruction& instr);
     int32_t executeALU(const Instruction& instr, int32_t op1, int32_t op2);
     bool pipelineEmpty() const;
+    bool runLoop(AsyncWriter<DebugSnapshot>* debugLog, size_t stopCycle,
+                 StopCheck until = nullptr, void* context = nullptr);
+    bool runGuarded(AsyncWriter<DebugSnapshot>* debugLog, size_t stopCycle,
+                    StopCheck until = nullptr, void* context = nullptr);
+    void guardedStep();
+    void recordStep(TraceRecord& record);
+    void observedStep();
+    void callHooks(const TraceRecord& record, size_t fetchPc, const StallStats& before);
+    void profiledStep();
+    void printFinalState() const;
     
 public:
-    CPU(const Program& prog, bool debug = false);
+    // Many CPUs (a sweep, a cross-check) can share one Program; it must not
+    // change while they exist
+    CPU(std::shared_ptr<const Program> prog, bool debug = false,
+        ExecMode mode = ExecMode::PIPELINE, const PipelineConfig& config = PipelineConfig(),
+        MemoryBackend backend = MemoryBackend::PAGED);
+    // Takes a private copy of prog
+    CPU(const Program& prog, bool debug = false, ExecMode mode = ExecMode::PIPELINE,
+        const PipelineConfig& config = PipelineConfig(),
+        MemoryBackend backend = MemoryBackend::PAGED);
+    ~CPU();
     
+    // Run with console output (binary table, debug trace, final state)
     void run();
+    // Run to completion without printing anything
+    // Returns false if the cycle limit was hit first
+    bool execute();
+    // Run silently for at most the given number of cycles
+    // Returns true if the program finished
+    bool advance(size_t cycles);
+    // advance() that also stops as soon as until(context) returns true; the
+    // check runs before every step
+    bool advanceUntil(StopCheck until, void* context, size_t cycles);
+    bool finished() const;
+    void step();
+    
     void stepPipeline();
+    void stepFunctional();
+    void stepThreaded();
+    void stepBlock();
+    
+    // Stop run() and execute() after this many cycles (default 10000)
+    void setCycleLimit(size_t cycles) { cycleLimit = cycles; }
+    size_t getCycleLimit() const { return cycleLimit; }
+    // Record every cycle (pipeline) or instruction (functional, threaded) to
+    // writer; nullptr turns tracing off. Block and JIT modes are not traced.
+    void setTrace(TraceWriter* writer) { tracer = writer; }
+    // Charge every cycle to the PC responsible (see profiler.h); nullptr turns
+    // profiling off. Block and JIT modes are not profiled.
+    void setProfiler(Profiler* target) { profiler = target; }
+    // Time run() on the host: wall time, throughput, progress line and
+    // sampled per-stage cost (see hoststats.h); nullptr turns it off
+    void setHostStats(HostStats* stats) { hostStats = stats; }
+    // Call hooks on every fetch, memory access and retirement (see hooks.h);
+    // nullptr removes them. Block and JIT modes are not hooked.
+    void setHooks(ExecHooks* target) { hooks = target; }
+    // Queue between the simulation and the thread that prints --debug output
+    void setLogQueue(LogPolicy policy, size_t capacity) {
+        logPolicy = policy;
+        logCapacity = capacity;
+    }
+    // Write the performance counters at the end of run(), to path or (if
+    // empty) to stdout
+    void setCounterReport(CounterFormat format, const std::string& path = "") {
+        counterFormat = format;
+        counterPath = path;
+    }
+    
+    // Replace the binary table and final state dump of run() with one
+    // json, csv or binary report on stdout (see report.h)
+    void setOutputFormat(OutputFormat format) { outputFormat = format; }
+    
+    // Binary checkpoint of pc, registers, dirty memory pages, pipeline
+    // registers and counters (see checkpoint.h); errors throw runtime_error
+    void saveCheckpoint(const std::string& path) const;
+    // Restore into a freshly constructed CPU built from the same program
+    void loadCheckpoint(const std::string& path);
     
     // Accessors for debug output
     const std::array<int32_t, 32>& getRegisters() const { return registers; }
-    const std::vector<int32_t>& getMemory() const { return memory; }
+    const GuestMemory& getMemory() const { return memory; }
+    // Writable state for embedders; registers written between steps are seen
+    // by instructions that have not been decoded yet
+    std::array<int32_t, 32>& getRegisters() { return registers; }
+    GuestMemory& getMemory() { return memory; }
     size_t getPC() const { return pc; }
     size_t getCycleCount() const { return cycleCount; }
+    size_t getInstructionCount() const { return instructionCount; }
+    ExecMode getMode() const { return mode; }
+    const PipelineConfig& getConfig() const { return config; }
+    const StallStats& getStallStats() const { return stalls; }
+    const std::vector<BranchStats>& getBranchStats() const { return branchStats; }
+    PerfCounters getCounters() const;
+    const BranchPredictor* getPredictor() const { return predictor.get(); }
+    const Cache* getICache() const { return icache.get(); }
+    const Cache* getDCache() const { return dcache.get(); }
+    const std::vector<SourceLine>& getSource() const { return source; }
     
     const IF_ID& getIF_ID() const { return if_id; }
     const ID_EX& getID_EX() const { return id_ex; }
@@ -156,4 +476,7 @@ public:
 // Convert opcode to string
 std::string opcodeToString(Opcode op);
 
+// Convert engine to string
+std::string execModeToString(ExecMode mode);
+
 #endif // CPU_H
@@ -3,36 +3,88 @@
 
 #include "cpu.h"
 #include <array>
+#include <iostream>
 #include <vector>
 using namespace std;
 
 // Declares Debug class with static print functions for registers, memory, pipeline state, and binary representation
 
+// Copy of everything the per-cycle debug view shows, taken on the simulation
+// thread so the text can be formatted on the output thread
+struct DebugSnapshot {
+    ExecMode mode;
+    size_t cycle;
+    size_t pc;          // PC after the step
+    size_t fetchPc;     // PC of the instruction just executed (functional modes)
+    IF_ID if_id;
+    ID_EX id_ex;
+    EX_MEM ex_mem;
+    MEM_WB mem_wb;
+    std::array<int32_t, 32> registers;
+    
+    DebugSnapshot() : mode(ExecMode::PIPELINE), cycle(0), pc(0), fetchPc(0) {}
+};
+
 class Debug {
 public:
     // Print register file contents
-    static void printRegisters(const std::array<int32_t, 32>& registers);
+    static void printRegisters(const std::array<int32_t, 32>& registers,
+                               std::ostream& out = std::cout);
     
     // Print non-zero memory locations
-    static void printMemory(const std::vector<int32_t>& memory);
+    static void printMemory(const GuestMemory& memory);
     
     // Print control signals
-    static void printControlSignals(const ControlSignals& ctrl);
+    static void printControlSignals(const ControlSignals& ctrl, std::ostream& out = std::cout);
     
     // Print pipeline register contents
-    static void printIF_ID(const IF_ID& reg);
-    static void printID_EX(const ID_EX& reg);
-    static void printEX_MEM(const EX_MEM& reg);
-    static void printMEM_WB(const MEM_WB& reg);
+    // Instruction text is looked up in the source table by the latch PC
+    static void printIF_ID(const IF_ID& reg, const std::vector<SourceLine>& source,
+                           std::ostream& out = std::cout);
+    static void printID_EX(const ID_EX& reg, const std::vector<SourceLine>& source,
+                           std::ostream& out = std::cout);
+    static void printEX_MEM(const EX_MEM& reg, const std::vector<SourceLine>& source,
+                            std::ostream& out = std::cout);
+    static void printMEM_WB(const MEM_WB& reg, const std::vector<SourceLine>& source,
+                            std::ostream& out = std::cout);
+    
+    // Print hazard unit configuration, stall counts by cause and CPI
+    static void printStallStats(const CPU& cpu);
+    
+    // Print predictor accuracy and per-PC branch outcome/mispredict counts
+    static void printBranchStats(const CPU& cpu);
+    
+    // Print I-cache/D-cache configuration and hit/miss counters
+    static void printCacheStats(const CPU& cpu);
     
-    // Print full pipeline state (called each cycle in debug mode)
-    static void printPipelineState(const CPU& cpu);
+    // Snapshot the state shown after each cycle/step in debug mode
+    static void capture(const CPU& cpu, size_t fetchPc, DebugSnapshot& snapshot);
+    
+    // Print a snapshot in the pipeline or functional layout, by its mode
+    static void printState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                           std::ostream& out);
+    
+    // Print full pipeline state (each cycle in debug mode)
+    static void printPipelineState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                                   std::ostream& out);
+    
+    // Print the instruction just executed and the register file (functional mode)
+    static void printFunctionalState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                                     std::ostream& out);
+    
+    // Compare final registers and memory of two runs, printing any mismatch
+    // Returns true if the architectural state is identical
+    static bool compareState(const CPU& expected, const CPU& actual);
     
     // Print binary representation of instructions
-    static void printBinaryRepresentation(const std::vector<Instruction>& instructions);
+    static void printBinaryRepresentation(const std::vector<Instruction>& instructions,
+                                          const std::vector<SourceLine>& source);
     
     // Get register name from number
     static string regName(int reg);
+    
+    // Get original assembly text for the instruction at pc
+    static const string& sourceText(const std::vector<SourceLine>& source, size_t pc);
 };
 
 #endif // DEBUG_H
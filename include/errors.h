@@ -25,6 +25,9 @@ public:
     void addError(int line, const std::string& message);
     bool hasErrors() const;
     size_t errorCount() const;
+    // Order errors by source line (stable for errors on the same line)
+    void sortByLine();
+    const std::vector<Error>& getErrors() const { return errors; }
     void printErrors() const;
     bool writeErrorFile(const std::string& filename) const;
     void clear();
@@ -0,0 +1,134 @@
+#ifndef GUESTMEM_H
+#define GUESTMEM_H
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <csetjmp>
+#include <string>
+
+// Declares GuestMemory: guest memory covering the full 32-bit address space,
+// with two backends:
+//   PAGED - 4 KiB pages allocated on first store behind a two-level page table;
+//           loads from untouched pages read as zero
+//   FLAT  - one 4 GiB PROT_NONE reservation (Linux only); pages are committed on
+//           first touch by a SIGSEGV handler, so an access is a single host
+//           load/store from the base pointer with no table walk or bounds check.
+//           The handler is process-wide: the first FLAT memory installs it,
+//           it is never removed, and faults outside every live FLAT memory go
+//           to the handler it replaced
+
+enum class MemoryBackend { PAGED, FLAT };
+
+class GuestMemory {
+public:
+    static const unsigned PAGE_BITS = 12;
+    static const uint32_t PAGE_SIZE = 1u << PAGE_BITS;   // Bytes per page
+    static const uint32_t PAGE_WORDS = PAGE_SIZE / 4;
+    static const uint32_t PAGE_COUNT = 1u << (32 - PAGE_BITS);
+    
+    // Turns a FLAT memory fault that cannot be serviced (commit failure) into a
+    // guest fault. Arm it with sigsetjmp(scope.env, ...) in the frame that runs
+    // the simulation; the handler siglongjmps back there, skipping destructors,
+    // so nothing between that frame and the access may own resources (see
+    // CPU::runGuarded). A fault outside any scope is left to the previous
+    // SIGSEGV handler.
+    struct FaultScope {
+        sigjmp_buf env;
+        FaultScope();
+        ~FaultScope();
+    };
+    
+    // Guest address of the last fault delivered to a FaultScope on this thread
+    static uint32_t lastFaultAddress();
+    
+private:
+    struct Page {
+        std::array<int32_t, PAGE_WORDS> words;
+        uint32_t number;   // Page number (address >> PAGE_BITS)
+        bool dirty;        // Written since the last clearDirty()
+        
+        Page(uint32_t n) : number(n), dirty(false) { words.fill(0); }
+    };
+    
+    static const unsigned DIR_BITS = 10;                        // First-level index
+    static const unsigned TABLE_BITS = 32 - PAGE_BITS - DIR_BITS;  // Second-level index
+    
+    typedef std::array<Page*, 1u << TABLE_BITS> PageTable;
+    
+    MemoryBackend backend;
+    
+    // PAGED backend
+    std::array<std::unique_ptr<PageTable>, 1u << DIR_BITS> directory;
+    std::vector<std::unique_ptr<Page>> pages;   // Owned pages, in allocation order
+    
+    // Last page hit: the hot path is a compare against this before any table walk
+    mutable uint32_t lastNumber;
+    mutable Page* lastPage;
+    
+    // FLAT backend (flatBase is nullptr when PAGED)
+    uint8_t* flatBase;
+    std::vector<uint64_t> committed;   // Bitmap of committed pages
+    std::vector<uint64_t> dirtyBits;   // Bitmap of pages written since clearDirty()
+    
+    Page* findPage(uint32_t number) const;
+    Page* allocatePage(uint32_t number);
+    bool initFlat();
+    
+    friend struct FlatFaultHandler;
+    
+public:
+    // FLAT falls back to PAGED when the reservation is not possible on this host
+    GuestMemory(MemoryBackend backend = MemoryBackend::PAGED);
+    ~GuestMemory();
+    
+    GuestMemory(const GuestMemory&) = delete;
+    GuestMemory& operator=(const GuestMemory&) = delete;
+    
+    // Word access by byte address (the low two bits are ignored)
+    int32_t load(uint32_t address) const {
+        if (flatBase) {
+            return *reinterpret_cast<const int32_t*>(flatBase + (address & ~3u));
+        }
+        uint32_t number = address >> PAGE_BITS;
+        const Page* page = (number == lastNumber) ? lastPage : findPage(number);
+        return page ? page->words[(address >> 2) & (PAGE_WORDS - 1)] : 0;
+    }
+    
+    void store(uint32_t address, int32_t value) {
+        if (flatBase) {
+            *reinterpret_cast<int32_t*>(flatBase + (address & ~3u)) = value;
+            return;
+        }
+        uint32_t number = address >> PAGE_BITS;
+        Page* page = (number == lastNumber && lastPage) ? lastPage : allocatePage(number);
+        page->words[(address >> 2) & (PAGE_WORDS - 1)] = value;
+        page->dirty = true;
+    }
+    
+    // Numbers of the pages touched so far, in address order
+    std::vector<uint32_t> touchedPages() const;
+    
+    // Contents of a touched page, or nullptr if it was never touched
+    const int32_t* pageData(uint32_t number) const;
+    bool isPageDirty(uint32_t number) const;
+    
+    // Copy a whole page in (used when restoring state)
+    void writePage(uint32_t number, const int32_t* words);
+    // Map count consecutive pages starting at first straight from a file,
+    // copy-on-write. FLAT only: returns false when the caller must copy instead
+    bool mapPages(uint32_t first, uint32_t count, int fd, uint64_t offset);
+    
+    size_t pageCount() const;
+    size_t dirtyPageCount() const;
+    void clearDirty();
+    
+    MemoryBackend getBackend() const { return backend; }
+    bool isFlat() const { return flatBase != nullptr; }
+    uint8_t* getFlatBase() const { return flatBase; }
+};
+
+std::string memoryBackendToString(MemoryBackend backend);
+
+#endif // GUESTMEM_H
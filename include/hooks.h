@@ -0,0 +1,35 @@
+#ifndef HOOKS_H
+#define HOOKS_H
+
+#include "cpu.h"
+#include <cstddef>
+#include <cstdint>
+
+// Declares ExecHooks: callbacks an embedding program installs with
+// CPU::setHooks (or Simulator::setHooks) to observe fetches, memory accesses
+// and retirements. PCs are instruction indices.
+//
+// A CPU without hooks never looks at them: the pointer is checked once per
+// run call to pick the observed loop, the same way tracing and profiling are,
+// so the plain loop carries no per-step test. With hooks installed every step
+// goes through the observed loop, which rebuilds the events from the latches
+// as the trace does (see CPU::recordStep). Each step reports its fetch, then
+// its memory access, then its retirement. The pipeline reports every fetch,
+// including wrong-path fetches that are flushed later, and nothing on a cycle
+// frozen by a stall. Block and JIT modes are not hooked. Hooks run outside
+// the flat-memory fault scope (see CPU::runGuarded), so they may own
+// resources and touch guest memory.
+
+class ExecHooks {
+public:
+    virtual ~ExecHooks() {}
+
+    virtual void onFetch(size_t pc) { (void)pc; }
+    // value is the word loaded or stored
+    virtual void onMemory(size_t pc, uint32_t address, int32_t value, bool write) {
+        (void)pc; (void)address; (void)value; (void)write;
+    }
+    virtual void onRetire(size_t pc, const Instruction& instr) { (void)pc; (void)instr; }
+};
+
+#endif // HOOKS_H
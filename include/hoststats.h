@@ -0,0 +1,105 @@
+#ifndef HOSTSTATS_H
+#define HOSTSTATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HOSTSTATS_TSC 1
+#include <x86intrin.h>
+#endif
+
+// Declares HostStats: measures the simulator itself rather than the guest.
+// CPU::run() records wall time and simulated cycles and instructions per host
+// second, can refresh a progress line on stderr, and on sampled cycles times
+// each pipeline stage and the debug snapshot with the time stamp counter
+// (steady_clock where there is no TSC). Sampling keeps the cost off the other
+// cycles: an unsampled cycle pays one test per stage.
+
+// Host time buckets; the stages follow the order stepPipeline() runs them in
+enum HostStage {
+    HOST_WB,
+    HOST_MEM,       // Including D-cache lookups and freezes
+    HOST_EX,        // Including forwarding
+    HOST_ID,        // Hazard detection and decode
+    HOST_IF,        // I-cache, predictor and fetch
+    HOST_RESOLVE,   // Branch resolution and latch update
+    HOST_STAGES
+};
+
+class HostStats {
+private:
+    // Run totals
+    std::chrono::steady_clock::time_point wallStart;
+    double wallSeconds;
+    uint64_t tickStart;
+    uint64_t ticks;
+    size_t startCycles, startInstructions;
+    size_t cycles, instructions;
+
+    // Sampled costs
+    size_t sampleMask;              // Sample when (cycle & mask) == 0; SIZE_MAX = off
+    size_t samples;
+    uint64_t stageTicks[HOST_STAGES];
+    uint64_t lastMark;
+    size_t debugSamples;
+    uint64_t debugTicks;            // Debug::capture and queueing, simulation thread
+    uint64_t formatTicks;           // Debug formatting, writer thread only until it is joined
+
+    // Progress line
+    double progressInterval;        // Seconds, 0 = off
+    double nextProgress;
+    bool progressShown;
+
+public:
+    HostStats();
+
+    static uint64_t now() {
+#ifdef HOSTSTATS_TSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Time stages on one cycle in every period (rounded up to a power of
+    // two); 0 turns sampling off
+    void setSamplePeriod(size_t period);
+    size_t getSamplePeriod() const { return sampleMask == SIZE_MAX ? 0 : sampleMask + 1; }
+    bool sampling(size_t cycle) const { return sampleMask != SIZE_MAX && (cycle & sampleMask) == 0; }
+
+    // Stage timing within one sampled cycle: startSample(), then mark() as
+    // each stage finishes
+    void startSample() {
+        samples++;
+        lastMark = now();
+    }
+    void mark(HostStage stage) {
+        uint64_t t = now();
+        stageTicks[stage] += t - lastMark;
+        lastMark = t;
+    }
+    void addDebugSample(uint64_t elapsed) {
+        debugSamples++;
+        debugTicks += elapsed;
+    }
+    void addFormatTicks(uint64_t elapsed) { formatTicks += elapsed; }
+
+    // Refresh the progress line every interval seconds (0 = never)
+    void setProgressInterval(double seconds) { progressInterval = seconds; }
+    bool progressEnabled() const { return progressInterval > 0; }
+    void progress(size_t cycleCount, size_t instructionCount);
+
+    void begin(size_t cycleCount, size_t instructionCount);
+    void end(size_t cycleCount, size_t instructionCount);
+
+    double seconds() const { return wallSeconds; }
+    double cyclesPerSecond() const;
+    double instructionsPerSecond() const;
+
+    void report(std::ostream& out) const;
+};
+
+#endif // HOSTSTATS_H
@@ -0,0 +1,61 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "blockcache.h"
+#include <vector>
+#include <cstdint>
+
+// Declares the JitCompiler class that translates hot basic blocks into native
+// x86-64 code in mmap'd executable memory (Linux x86-64 hosts only)
+
+class JitCompiler {
+private:
+    uint8_t* code;       // Executable region: entry trampoline, epilogue, then blocks
+    size_t capacity;     // Region size in bytes
+    size_t used;         // Bytes emitted so far
+    uint8_t* flatBase;   // FLAT guest memory base, or nullptr for paged memory
+    const uint8_t* epilogue;          // Shared exit back to run()'s caller
+    std::vector<const void*> entries; // Per pc: compiled block entry, else the epilogue
+    
+    // Emit native code for one block into buf, to be placed at base
+    void emitBlock(
+        const BasicBlock& block,
+        const std::vector<MicroOp>& microOps,
+        const uint8_t* base,
+        std::vector<uint8_t>& buf
+    ) const;
+    
+    // Copy buf into the region, returns where it landed or nullptr if full
+    const uint8_t* install(const std::vector<uint8_t>& buf);
+
+public:
+    // Blocks are compiled after this many interpreted executions
+    static const size_t HOT_THRESHOLD = 16;
+    
+    // With a FLAT guest memory base, LW/SW become single host loads/stores
+    // from that base; otherwise they call into GuestMemory
+    JitCompiler(size_t programSize, uint8_t* flatBase = nullptr,
+                size_t capacityBytes = 4 << 20);
+    ~JitCompiler();
+    
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler& operator=(const JitCompiler&) = delete;
+    
+    // True when native code can be generated on this host
+    static bool available();
+    
+    // Compile a block, returns its entry or nullptr if out of code space
+    // Compiled predecessors jump straight to it from then on
+    const void* compile(const BasicBlock& block, const std::vector<MicroOp>& microOps);
+    
+    // Run native code from a compiled block's entry, chaining from block to
+    // block until budget (instructions) is used up or the next block is not
+    // compiled; budget is charged a whole block at a time and may go below 0
+    // Returns the next pc
+    size_t run(const void* entry, int32_t* registers, GuestMemory* memory,
+               int64_t& budget) const;
+    
+    size_t codeSize() const { return used; }
+};
+
+#endif // JIT_H
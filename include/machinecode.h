@@ -0,0 +1,29 @@
+#ifndef MACHINECODE_H
+#define MACHINECODE_H
+
+#include "cpu.h"
+#include <cstdint>
+#include <string>
+
+// Declares MachineCode: MIPS32 encoding and decoding of the supported subset.
+// Branch and jump targets in an Instruction are instruction indexes; in a
+// machine word they are a PC-relative word offset (BEQ) or the low 28 bits of
+// a word address (J), so both directions take the instruction's position.
+
+class MachineCode {
+public:
+    // Encode one instruction at index pc; 0xFFFFFFFF if it has no encoding
+    static uint32_t encode(const Instruction& instr, size_t pc);
+
+    // Decode one word found at index pc of a text section that starts at byte
+    // address textBase. Returns false for anything outside the supported subset.
+    // ADDU, ADDIU and SUBU decode as ADD, ADDI and SUB (the simulator never
+    // traps on overflow, so they behave identically).
+    static bool decode(uint32_t word, size_t pc, uint32_t textBase, Instruction& instr);
+
+    // Assembly text for a decoded instruction, in a form the parser accepts
+    // (branch targets as relative offsets, jump targets as indexes)
+    static std::string disassemble(const Instruction& instr, size_t pc);
+};
+
+#endif // MACHINECODE_H
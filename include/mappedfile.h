@@ -0,0 +1,40 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Declares MappedFile: a read-only view of a whole file, mmap'd where the
+// platform allows it and read into a buffer otherwise
+
+class MappedFile {
+private:
+    const uint8_t* bytes;
+    size_t length;
+    int descriptor;                // Open while mapped, -1 otherwise
+    std::vector<uint8_t> buffer;   // Fallback storage when not mapped
+
+    void close();
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or read
+    bool open(const std::string& path);
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+    // Descriptor of the mapped file (for mapping parts of it again), or -1
+    int fd() const { return descriptor; }
+    std::string_view text() const {
+        return std::string_view(reinterpret_cast<const char*>(bytes), length);
+    }
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,113 @@
+#ifndef MIPSSIM_H
+#define MIPSSIM_H
+
+#include "cpu.h"
+#include "binloader.h"
+#include "hooks.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Declares Simulator: the embedding API of libmipssim. One Simulator owns one
+// CPU and drives it through CPU::advance, never through CPU::run() (the
+// mips_sim driver, which still prints to cout), so nothing is printed and the
+// terminal is never read. Simulators share no state, so many can run side by
+// side, one per thread, with one exception: the first flat-memory Simulator
+// installs a process-wide SIGSEGV handler that chains to the one it replaced
+// and stays installed (see guestmem.h). Programs come from assemble() or
+// load(), or are built directly as a Program. Errors throw runtime_error.
+//
+//   Program program = Simulator::assemble(text);
+//   Simulator sim(program);
+//   sim.runUntil([](const Simulator& s) { return s.reg(2) == 42; }, 100000);
+//   int32_t result = sim.memory().load(0x100);
+//
+// There is no cycle limit beyond the budget passed to each call.
+
+struct SimOptions {
+    ExecMode mode;
+    PipelineConfig config;
+    MemoryBackend backend;
+
+    SimOptions() : mode(ExecMode::PIPELINE), backend(MemoryBackend::PAGED) {}
+};
+
+// Why step() or runUntil() returned
+enum class RunResult {
+    FINISHED,    // The program ran off its end and the pipeline drained
+    STOPPED,     // The runUntil predicate returned true
+    BUDGET       // The cycle budget ran out first
+};
+
+class Simulator {
+private:
+    CPU cpu;
+
+public:
+    // Copies program; the shared_ptr form shares one read-only Program
+    // between any number of simulators
+    explicit Simulator(const Program& program, const SimOptions& options = SimOptions());
+    explicit Simulator(std::shared_ptr<const Program> program,
+                       const SimOptions& options = SimOptions());
+
+    // Parse assembly text; throws runtime_error with the first diagnostic
+    static Program assemble(std::string_view text);
+    // Read an assembly, object or ELF file (raw machine code when flat is set).
+    // Machine code that needs branch delay slots is rejected unless
+    // ignoreDelaySlots is set (see binloader.h).
+    static Program load(const std::string& path, bool flat = false,
+                        ByteOrder order = ByteOrder::BIG, bool ignoreDelaySlots = false);
+
+    // Run at most cycles cycles (pipeline) or instructions (other engines;
+    // block and JIT finish the block they are in)
+    RunResult step(size_t cycles = 1);
+
+    // Run until stop(*this) returns true, checked before every step, or
+    // until cycleBudget cycles have run
+    template <typename Predicate>
+    RunResult runUntil(Predicate stop, size_t cycleBudget);
+
+    // Architectural state, read and written in place
+    std::array<int32_t, 32>& registers() { return cpu.getRegisters(); }
+    const std::array<int32_t, 32>& registers() const { return cpu.getRegisters(); }
+    // Throws out_of_range unless 0 <= index < 32
+    int32_t reg(int index) const { return cpu.getRegisters().at(index); }
+    GuestMemory& memory() { return cpu.getMemory(); }
+    const GuestMemory& memory() const { return cpu.getMemory(); }
+    size_t pc() const { return cpu.getPC(); }
+
+    bool finished() const { return cpu.finished(); }
+    size_t cycles() const { return cpu.getCycleCount(); }
+    size_t retired() const { return cpu.getInstructionCount(); }
+    PerfCounters counters() const { return cpu.getCounters(); }
+
+    // Observe fetches, memory accesses and retirements (see hooks.h); nullptr
+    // removes them. Throws runtime_error in block and JIT modes.
+    void setHooks(ExecHooks* hooks);
+
+    // The underlying CPU, for statistics, caches, predictor and checkpoints
+    CPU& getCPU() { return cpu; }
+    const CPU& getCPU() const { return cpu; }
+};
+
+template <typename Predicate>
+RunResult Simulator::runUntil(Predicate stop, size_t cycleBudget) {
+    struct Context {
+        Predicate* stop;
+        const Simulator* sim;
+        bool fired;
+    } context = {&stop, this, false};
+
+    cpu.advanceUntil([](void* data) {
+        Context* c = static_cast<Context*>(data);
+        c->fired = (*c->stop)(*c->sim);
+        return c->fired;
+    }, &context, cycleBudget);
+
+    if (context.fired) return RunResult::STOPPED;
+    return cpu.finished() ? RunResult::FINISHED : RunResult::BUDGET;
+}
+
+#endif // MIPSSIM_H
@@ -0,0 +1,86 @@
+#ifndef OBJFILE_H
+#define OBJFILE_H
+
+#include "cpu.h"
+#include "mappedfile.h"
+#include <cstdint>
+#include <string>
+
+// Declares ObjectFile: a pre-assembled Program that loads without any text
+// parsing. Written by --emit-obj; any input file that starts with the object
+// magic is loaded instead of parsed. All fields are in host byte order:
+//
+//   ObjectHeader
+//   ObjectInstruction instructions[instructionCount]
+//   ObjectLine        lines[instructionCount]         source text + line number
+//   ObjectLabel       labels[labelCount]
+//   ObjectSegment     segments[segmentCount]          initialised data (binaries)
+//   int32_t           words[wordCount]                segment contents
+//   char              strings[stringBytes]            source texts and label names
+//
+// Every section starts on an 8-byte boundary.
+
+static const char OBJECT_MAGIC[8] = {'M', 'I', 'P', 'S', 'O', 'B', 'J', 0};
+static const uint32_t OBJECT_VERSION = 2;
+
+struct ObjectHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t instructionCount;
+    uint32_t labelCount;
+    uint32_t entry;             // Program::entry
+    uint32_t segmentCount;
+    uint32_t reserved;
+    uint64_t instructionOffset;
+    uint64_t lineOffset;
+    uint64_t labelOffset;
+    uint64_t segmentOffset;
+    uint64_t wordOffset;
+    uint64_t wordCount;
+    uint64_t stringOffset;
+    uint64_t stringBytes;
+};
+
+// Packed Instruction (16 bytes)
+struct ObjectInstruction {
+    uint8_t op;
+    uint8_t rs;
+    uint8_t rt;
+    uint8_t rd;
+    int32_t shamt;
+    int32_t imm;
+    uint32_t target;
+};
+
+struct ObjectLine {
+    uint32_t textOffset;   // Into the string table
+    uint32_t textLength;
+    int32_t line;          // Line number in the original .asm file
+};
+
+struct ObjectLabel {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t index;        // Instruction the label points to
+};
+
+struct ObjectSegment {
+    uint32_t address;
+    uint32_t wordCount;
+    uint64_t firstWord;    // Index into the words section
+};
+
+class ObjectFile {
+public:
+    // Write a program; throws runtime_error on failure
+    static void write(const Program& program, const std::string& path);
+
+    // True if the mapped file starts with the object magic
+    static bool matches(const MappedFile& file);
+
+    // Rebuild a program from a mapped object file; throws runtime_error if it
+    // is truncated, corrupt or from another version
+    static Program load(const MappedFile& file);
+};
+
+#endif // OBJFILE_H
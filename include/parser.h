@@ -4,28 +4,50 @@
 #include "cpu.h"
 #include "errors.h"
 #include <string>
+#include <string_view>
 #include <istream>
+#include <array>
+#include <vector>
+#include <unordered_map>
 
-// Declares the Parser class with parse() method and helper functions for reading assembly files
+// Declares the Parser class: a single-pass assembler front end over a
+// string_view of the whole source (memory-mapped by parseFile). Mnemonics and
+// register names are found with perfect hashes, and branch/jump targets that
+// name a label not yet seen are backpatched once the whole file is read.
 
 class Parser {
 private:
+    // A BEQ/J whose label was not defined yet when the instruction was parsed
+    struct Fixup {
+        size_t index;            // Instruction to patch
+        size_t lineIndex;        // Position among instruction lines (for numeric offsets)
+        std::string_view label;  // Points into the source text
+        int line;
+    };
+
     ErrorHandler& errorHandler;
     Program program;
-    
+    std::unordered_map<std::string_view, size_t> labels;
+    std::vector<Fixup> fixups;
+
     // Helper methods
-    std::string trim(const std::string& s);
-    std::string toUpper(const std::string& s);
-    int parseRegister(const std::string& reg, int lineNum);
-    Opcode parseOpcode(const std::string& mnemonic);
-    std::vector<std::string> splitOperands(const std::string& operandStr);
-    
+    static std::string_view trim(std::string_view s);
+    static size_t splitOperands(std::string_view operandStr, std::array<std::string_view, 4>& operands);
+    int parseRegister(std::string_view reg, int lineNum);
+    Opcode parseOpcode(std::string_view mnemonic);
+    void parseInstruction(std::string_view text, int lineNum, size_t lineIndex);
+    void resolveFixups();
+
 public:
     Parser(ErrorHandler& eh);
-    
-    // Parse assembly from input stream
+
+    // Parse assembly source text
+    Program parse(std::string_view text);
+    // Parse assembly from input stream (read fully, then parsed as text)
     Program parse(std::istream& input);
-    
+    // Parse an assembly file through a read-only memory mapping
+    Program parseFile(const std::string& path);
+
     // Check if parsing succeeded
     bool success() const;
 };
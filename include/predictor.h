@@ -0,0 +1,124 @@
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "cpu.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+// Declares the BranchPredictor interface consulted by the fetch stage and its
+// implementations: always-not-taken, BTFN, 1-bit, 2-bit, gshare and BTB
+
+class BranchPredictor {
+public:
+    virtual ~BranchPredictor() {}
+    
+    // Predict the next fetch PC after the control instruction at pc. index
+    // receives the table entry consulted; the pipeline carries it to EX with
+    // the prediction and passes it back to update()
+    virtual size_t predict(size_t pc, const Instruction& instr, size_t& index) = 0;
+    
+    // Train the entry used at fetch with the outcome resolved in EX. index is
+    // masked to the table, so one restored from a checkpoint taken with a
+    // larger table still lands in range
+    virtual void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                        size_t index) = 0;
+    
+    virtual std::string name() const = 0;
+    
+    // Build a predictor; tableSize is rounded up to a power of two
+    static std::unique_ptr<BranchPredictor> create(PredictorType type, size_t tableSize);
+};
+
+// Static: never taken
+class NotTakenPredictor : public BranchPredictor {
+public:
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "not-taken"; }
+};
+
+// Static: backward taken, forward not taken
+class BTFNPredictor : public BranchPredictor {
+public:
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "btfn"; }
+};
+
+// Last outcome per PC
+class OneBitPredictor : public BranchPredictor {
+private:
+    std::vector<bool> table;
+    size_t mask;
+    
+public:
+    OneBitPredictor(size_t tableSize);
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "1bit"; }
+};
+
+// 2-bit saturating counter per PC (0-1 not taken, 2-3 taken)
+class TwoBitPredictor : public BranchPredictor {
+private:
+    std::vector<uint8_t> table;
+    size_t mask;
+    
+public:
+    TwoBitPredictor(size_t tableSize);
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "2bit"; }
+};
+
+// 2-bit counters indexed by PC xor global branch history. The history is
+// shifted when branches resolve, so by then it no longer matches the index
+// used at fetch; training goes to the fetch-time entry instead
+class GsharePredictor : public BranchPredictor {
+private:
+    std::vector<uint8_t> table;
+    size_t mask;
+    size_t history;
+    
+public:
+    GsharePredictor(size_t tableSize);
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "gshare"; }
+};
+
+// Direct-mapped branch target buffer with a 2-bit counter per entry
+// Only branches that hit in the BTB can be predicted taken
+class BTBPredictor : public BranchPredictor {
+private:
+    struct Entry {
+        bool valid;
+        size_t tag;      // Full branch PC
+        size_t target;
+        uint8_t counter;
+        
+        Entry() : valid(false), tag(0), target(0), counter(0) {}
+    };
+    
+    std::vector<Entry> table;
+    size_t mask;
+    
+public:
+    BTBPredictor(size_t tableSize);
+    size_t predict(size_t pc, const Instruction& instr, size_t& index) override;
+    void update(size_t pc, const Instruction& instr, bool taken, size_t target,
+                size_t index) override;
+    std::string name() const override { return "btb"; }
+};
+
+// Convert predictor type to/from its command line name
+std::string predictorTypeToString(PredictorType type);
+bool parsePredictorType(const std::string& name, PredictorType& type);
+
+#endif // PREDICTOR_H
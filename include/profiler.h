@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "cpu.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Declares Profiler: attributes every simulated cycle, stall and flush to the
+// PC of the instruction responsible and reports a flat profile, a profile by
+// label region and an annotated source listing.
+//
+// Pipeline cycles go to the instruction retiring in WB. Every bubble carries
+// the PC that caused it down the pipe, and the cycle in which it reaches WB
+// is charged there: flush bubbles to the mispredicted branch or jump, hazard
+// bubbles to the instruction held in IF/ID, I-cache bubbles to the PC being
+// fetched. A D-cache freeze goes to the load or store in EX/MEM, and bubbles
+// of unknown origin (pipeline fill and drain) to the oldest instruction in
+// flight. The functional and threaded engines charge one cycle per instruction.
+
+// What one pipeline step did, for Profiler::chargePipeline
+struct PipelineStep {
+    bool valid[4];          // IF/ID, ID/EX, EX/MEM, MEM/WB before the step
+    size_t latchPc[4];
+    size_t fetchPc;         // PC before the step
+    bool frozen;            // D-cache froze the whole pipeline
+    size_t hazardStalls;    // Bubbles the hazard unit inserted
+    bool icacheStall;
+    bool flushed;
+};
+
+// Cost of one PC
+struct ProfileEntry {
+    size_t cycles;
+    size_t retired;
+    size_t stalls;       // Hazard and cache stall cycles charged here
+    size_t flushes;
+
+    ProfileEntry() : cycles(0), retired(0), stalls(0), flushes(0) {}
+};
+
+class Profiler {
+private:
+    std::vector<ProfileEntry> entries;      // Indexed by PC
+    std::vector<SourceLine> source;
+    std::vector<std::string> regionOf;      // Nearest label at or before each PC
+    size_t unattributed;                    // Cycles with no instruction in sight
+    size_t bubbleCause[4];                  // PC each latch's bubble is charged to
+
+public:
+    explicit Profiler(const Program& program);
+
+    // Accounting, called by the CPU after each step
+    void chargeCycle(size_t pc, bool retired);
+    void chargePipeline(const PipelineStep& step);
+
+    const std::vector<ProfileEntry>& getEntries() const { return entries; }
+    size_t totalCycles() const;
+
+    // Flat profile (top rows by cycles), regions and the annotated listing
+    void report(std::ostream& out, size_t top = 20) const;
+};
+
+#endif // PROFILER_H
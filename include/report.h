@@ -0,0 +1,58 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "cpu.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Declares StateReport: the machine-readable end-of-run output selected with
+// --output=json|csv|bin, written instead of the formatted tables in CPU::run.
+// Everything goes through one fixed-size buffer that is handed to fwrite only
+// when it fills, so a small report is a single write and a large memory image
+// is streamed page by page instead of being built in memory.
+//
+// json   one object: engine, status, cycles, retired, pc, registers, the
+//        --counters object, caches, branch prediction and the non-zero memory
+//        words as [address, value] pairs
+// csv    section,name,value rows carrying the same fields
+// bin    the layout below, all fields in host byte order:
+//
+//   OutputHeader
+//   PerfCounters                      raw image (countersSize in the header);
+//                                     instructionMix tells whether the
+//                                     opcode, load, store and branch counts
+//                                     were collected; padding bytes are 0
+//   { uint32_t page; int32_t words[PAGE_WORDS]; }   each touched page that
+//                                     holds a non-zero word, ascending
+//   uint32_t OUTPUT_END
+
+static const char OUTPUT_MAGIC[8] = {'M', 'I', 'P', 'S', 'O', 'U', 'T', 0};
+static const uint32_t OUTPUT_VERSION = 2;
+static const uint32_t OUTPUT_END = 0xFFFFFFFFu;
+
+struct OutputHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;              // ExecMode of the run
+    uint32_t finished;          // 0 if the cycle limit stopped it
+    uint32_t pageWords;         // GuestMemory::PAGE_WORDS
+    uint32_t countersSize;      // sizeof(PerfCounters)
+    uint32_t reserved;
+    uint64_t pc;                // Byte address
+    uint64_t cycleCount;
+    uint64_t instructionCount;
+    int32_t registers[32];
+};
+
+class StateReport {
+public:
+    // Parse "json", "csv" or "bin"; false for anything else
+    static bool parseFormat(const std::string& text, OutputFormat& format);
+
+    // Write the final state of cpu to out; throws runtime_error if the write
+    // fails
+    static void write(const CPU& cpu, OutputFormat format, std::FILE* out);
+};
+
+#endif // REPORT_H
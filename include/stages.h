@@ -8,16 +8,21 @@
 
 class PipelineStages {
 public:
+    // Each stage also counts its events (retired opcodes and bubbles in WB,
+    // loads and stores in MEM, branch outcomes in EX) into counters
+
     // Execute Write Back stage
     static void wbStage(
         const MEM_WB& mem_wb,
-        std::array<int32_t, 32>& registers
+        std::array<int32_t, 32>& registers,
+        PerfCounters& counters
     );
     
     // Execute Memory stage
     static MEM_WB memStage(
         const EX_MEM& ex_mem,
-        std::vector<int32_t>& memory
+        GuestMemory& memory,
+        PerfCounters& counters
     );
     
     // Execute Execute stage
@@ -25,7 +30,8 @@ public:
     static EX_MEM exStage(
         const ID_EX& id_ex,
         bool& branchTaken,
-        size_t& branchTarget
+        size_t& branchTarget,
+        PerfCounters& counters
     );
     
     // Execute Decode stage
@@ -41,11 +47,42 @@ public:
         bool flush
     );
     
+    // Forwarding unit: replace stale rs/rt values in ID/EX with results still
+    // in EX/MEM (ALU results only) or MEM/WB. EX/MEM has priority.
+    static void forward(
+        ID_EX& id_ex,
+        const EX_MEM& ex_mem,
+        const MEM_WB& mem_wb
+    );
+    
+    // Hazard detection unit: decide whether the instruction in IF/ID must wait
+    static StallCause detectHazard(
+        const IF_ID& if_id,
+        const ID_EX& id_ex,
+        const EX_MEM& ex_mem,
+        bool forwarding
+    );
+    
+    // Which source registers an instruction actually reads
+    static bool readsRs(const Instruction& instr);
+    static bool readsRt(const Instruction& instr);
+    
     // Generate control signals for an instruction
     static ControlSignals generateControl(const Instruction& instr);
     
     // Execute ALU operation
     static int32_t executeALU(const Instruction& instr, int32_t op1, int32_t op2);
+    
+    // Sign extend the low 16 bits of an immediate
+    static int32_t signExtend(int32_t imm);
+    
+    // Word access by byte address (the full 32-bit space is mapped)
+    static int32_t loadWord(const GuestMemory& memory, int32_t address) {
+        return memory.load(static_cast<uint32_t>(address));
+    }
+    static void storeWord(GuestMemory& memory, int32_t address, int32_t value) {
+        memory.store(static_cast<uint32_t>(address), value);
+    }
 };
 
 #endif // STAGES_H
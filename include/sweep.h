@@ -0,0 +1,42 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "cpu.h"
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Declares SweepRunner: design-space exploration over pipeline parameters.
+// The program is parsed once; every point of the parameter grid runs its own
+// pipeline CPU on the thread pool and produces one CSV row.
+
+// One swept parameter and the values it takes, e.g. "predictor=2bit,gshare"
+// Parameters: forwarding, hazard-detect (off|on), predictor, predictor-size,
+// icache, dcache (none|SIZE:LINE:WAYS[...])
+struct SweepAxis {
+    std::string name;
+    std::vector<std::string> values;
+};
+
+class SweepRunner {
+public:
+    // Parse "NAME=V1,V2,..." and check every value; returns false with a message
+    static bool parseAxis(const std::string& spec, SweepAxis& axis, std::string& error);
+
+    // Apply one parameter value to a configuration
+    static bool applyValue(const std::string& name, const std::string& value, PipelineConfig& config);
+
+    // Cartesian product of the axes over a base configuration, last axis fastest
+    static std::vector<PipelineConfig> expand(const std::vector<SweepAxis>& axes,
+                                              const PipelineConfig& base);
+
+    // Simulate every configuration and write the CSV (header plus one row per
+    // configuration, in grid order). maxCycles 0 keeps the CPU's default limit.
+    // Every configuration's CPU shares program; nothing copies it
+    static void run(std::shared_ptr<const Program> program,
+                    const std::vector<PipelineConfig>& configs,
+                    MemoryBackend backend, size_t jobs, size_t maxCycles, std::ostream& out);
+};
+
+#endif // SWEEP_H
@@ -0,0 +1,57 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Declares ThreadPool: a fixed set of worker threads, each with its own task
+// deque. A worker pops from the back of its own deque and, once that is empty,
+// steals from the front of the others, so a few long-running tasks do not hold
+// up the short ones queued behind them. Tasks must not throw.
+
+class ThreadPool {
+public:
+    typedef std::function<void()> Task;
+
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queue a task; tasks are dealt round-robin across the worker deques
+    void submit(Task task);
+    // Block until every submitted task has finished
+    void wait();
+    size_t size() const { return threads.size(); }
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex stateLock;
+    std::condition_variable wake;   // Signalled when work is queued or on shutdown
+    std::condition_variable idle;   // Signalled when pending drops to zero
+    std::atomic<size_t> queued;     // Tasks sitting in a deque
+    size_t pending;                 // Tasks submitted and not yet finished
+    size_t nextWorker;
+    bool stopping;
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+    void workerLoop(size_t index);
+};
+
+#endif // THREADPOOL_H
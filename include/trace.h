@@ -0,0 +1,128 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "asyncwriter.h"
+#include "mappedfile.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+
+// Declares the binary execution trace written by --trace and read by the
+// mips_trace tool. The file is a TraceHeader followed by one variable-length
+// record per cycle (pipeline) or per instruction (functional, threaded):
+//
+//   varint  flags                 TRACE_* bits below
+//   varint  cycle delta           from the previous record
+//   zigzag  stage PC delta        for each stage bit set, IF..WB, from the
+//                                 last PC recorded for that stage
+//   u8 reg, zigzag value          if TRACE_REG_WRITE
+//   zigzag address delta, value   if TRACE_MEM_READ or TRACE_MEM_WRITE
+//   zigzag branch PC delta        if TRACE_BRANCH
+//
+// Deltas keep a typical pipeline record to 7-9 bytes. The simulation thread
+// only queues TraceRecords; encoding and file writes happen on the writer
+// thread (see asyncwriter.h), and nothing is formatted until the file is
+// decoded offline.
+
+static const char TRACE_MAGIC[8] = {'M', 'I', 'P', 'S', 'T', 'R', 'C', 0};
+static const uint32_t TRACE_VERSION = 1;
+
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;              // ExecMode of the traced run
+    uint32_t programSize;       // Instruction count
+    uint32_t reserved;
+};
+
+enum TraceStage { TRACE_IF, TRACE_ID, TRACE_EX, TRACE_MEM, TRACE_WB, TRACE_STAGES };
+
+// Record flags; bits 0-4 say which stages hold an instruction
+static const uint32_t TRACE_REG_WRITE  = 1u << 5;
+static const uint32_t TRACE_MEM_READ   = 1u << 6;
+static const uint32_t TRACE_MEM_WRITE  = 1u << 7;
+static const uint32_t TRACE_BRANCH     = 1u << 8;   // BEQ or J resolved
+static const uint32_t TRACE_TAKEN      = 1u << 9;
+static const uint32_t TRACE_MISPREDICT = 1u << 10;
+static const uint32_t TRACE_STALL      = 1u << 11;  // Pipeline frozen on the D-cache
+
+// One decoded record
+struct TraceRecord {
+    uint64_t cycle;
+    uint32_t flags;
+    uint32_t stagePc[TRACE_STAGES];   // Valid where the stage bit is set
+    uint8_t reg;
+    int32_t regValue;
+    uint32_t memAddress;
+    int32_t memValue;
+    uint32_t branchPc;
+
+    TraceRecord() : cycle(0), flags(0), stagePc(), reg(0), regValue(0), memAddress(0),
+                    memValue(0), branchPc(0) {}
+
+    bool hasStage(int stage) const { return flags & (1u << stage); }
+    void setStage(int stage, uint32_t pc) {
+        flags |= 1u << stage;
+        stagePc[stage] = pc;
+    }
+};
+
+// Delta state shared by the encoder and decoder
+struct TraceState {
+    uint64_t cycle;
+    uint32_t stagePc[TRACE_STAGES];
+    uint32_t memAddress;
+    uint32_t branchPc;
+
+    TraceState() : cycle(0), stagePc(), memAddress(0), branchPc(0) {}
+};
+
+class TraceWriter {
+private:
+    std::ofstream out;
+    std::string path;
+    TraceState state;              // Writer thread only
+    uint64_t records;              // Writer thread only until close()
+    std::unique_ptr<AsyncWriter<TraceRecord>> queue;
+
+    void encode(const TraceRecord& record, std::string& batch);
+
+public:
+    TraceWriter();
+    ~TraceWriter();
+
+    // Create the file, write the header and start the writer thread; throws
+    // runtime_error on failure
+    void open(const std::string& path, uint32_t mode, uint32_t programSize,
+              LogPolicy policy = LogPolicy::BLOCK,
+              size_t capacity = AsyncWriter<TraceRecord>::DEFAULT_CAPACITY);
+    void write(const TraceRecord& record) { queue->push(record); }
+    // Drain the queue and close; throws runtime_error if any write failed
+    void close();
+
+    uint64_t recordCount() const { return records; }
+    size_t droppedCount() const { return queue ? queue->droppedCount() : 0; }
+};
+
+class TraceReader {
+private:
+    MappedFile file;
+    TraceHeader header;
+    size_t offset;
+    TraceState state;
+
+public:
+    TraceReader();
+
+    // Map the file and check the header; throws runtime_error on failure
+    void open(const std::string& path);
+    const TraceHeader& getHeader() const { return header; }
+    size_t size() const { return file.size(); }
+
+    // Decode the next record; false at end of file. Throws runtime_error on
+    // a truncated record.
+    bool next(TraceRecord& record);
+};
+
+#endif // TRACE_H
@@ -0,0 +1,25 @@
+#ifndef TRANSLATOR_H
+#define TRANSLATOR_H
+
+#include "cpu.h"
+#include <vector>
+
+// Declares the Translator class that turns Program::instructions into
+// threaded code (MicroOp array with per-opcode handlers) at load time
+
+class Translator {
+public:
+    // Translate a whole program into threaded code (one micro-op per instruction)
+    static std::vector<MicroOp> translate(const std::vector<Instruction>& instructions);
+    
+    // Translate a single instruction
+    static MicroOp translate(const Instruction& instr);
+    
+    // Try to fuse two adjacent micro-ops into one superinstruction
+    // Supported pairs: ADDI+BEQ (loop counter) and LW+ADD (load and accumulate)
+    // The fused handler reads the second half from the slot right after it,
+    // so the caller must keep `second` stored immediately after the result.
+    static bool fuse(const MicroOp& first, const MicroOp& second, MicroOp& fused);
+};
+
+#endif // TRANSLATOR_H
@@ -0,0 +1,234 @@
+#include "../include/batch.h"
+#include "../include/parser.h"
+#include "../include/errors.h"
+#include "../include/threadpool.h"
+#include "../include/mappedfile.h"
+#include "../include/binloader.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__)
+#define BATCH_GLOB 1
+#include <glob.h>
+#endif
+
+using namespace std;
+
+static string jsonEscape(const string& s) {
+    string out;
+    out.reserve(s.size() + 2);
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+static void expandPattern(const string& pattern, vector<string>& files) {
+#ifdef BATCH_GLOB
+    if (pattern.find_first_of("*?[") != string::npos) {
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+            for (size_t i = 0; i < matches.gl_pathc; i++) {
+                files.push_back(matches.gl_pathv[i]);
+            }
+        }
+        globfree(&matches);
+        return;
+    }
+#endif
+    files.push_back(pattern);
+}
+
+vector<string> BatchRunner::collect(const vector<string>& patterns, const vector<string>& listFiles) {
+    vector<string> files;
+    for (const string& pattern : patterns) {
+        expandPattern(pattern, files);
+    }
+
+    // List files hold one path or pattern per line; blank lines and # comments are skipped
+    for (const string& listFile : listFiles) {
+        ifstream listStream;
+        istream* in = &cin;
+        if (listFile != "-") {
+            listStream.open(listFile);
+            if (!listStream) {
+                throw runtime_error("Could not open list file '" + listFile + "'");
+            }
+            in = &listStream;
+        }
+
+        string line;
+        while (getline(*in, line)) {
+            size_t start = line.find_first_not_of(" \t\r");
+            size_t end = line.find_last_not_of(" \t\r");
+            if (start == string::npos || line[start] == '#') continue;
+            expandPattern(line.substr(start, end - start + 1), files);
+        }
+    }
+    return files;
+}
+
+uint64_t BatchRunner::memoryHash(const GuestMemory& memory) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    // All-zero pages are skipped so the hash does not depend on which backend
+    // materialised pages that were only read
+    for (uint32_t number : memory.touchedPages()) {
+        const int32_t* words = memory.pageData(number);
+        bool zero = true;
+        for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS && zero; i++) {
+            zero = (words[i] == 0);
+        }
+        if (zero) continue;
+
+        mix(number);
+        for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS; i++) {
+            mix(static_cast<uint32_t>(words[i]));
+        }
+    }
+    return hash;
+}
+
+BatchResult BatchRunner::runOne(const string& file, const BatchOptions& options) {
+    BatchResult result;
+    result.file = file;
+    auto start = chrono::steady_clock::now();
+
+    MappedFile input;
+    if (!input.open(file)) {
+        result.status = "io-error";
+        result.error = "Could not open file";
+    } else {
+        ErrorHandler errorHandler;
+        Parser parser(errorHandler);
+        Program program;
+        string loadError;
+        try {
+            if (!BinaryLoader::loadPrebuilt(input, options.flatBinary, options.byteOrder, program,
+                                             options.ignoreDelaySlots)) {
+                program = parser.parse(input.text());
+            }
+        } catch (const exception& e) {
+            loadError = e.what();
+        }
+
+        if (!loadError.empty()) {
+            result.status = "parse-error";
+            result.error = loadError;
+        } else if (errorHandler.hasErrors()) {
+            const Error& first = errorHandler.getErrors().front();
+            result.status = "parse-error";
+            result.error = "Line " + to_string(first.line) + ": " + first.message;
+        } else if (program.instructions.empty()) {
+            result.status = "parse-error";
+            result.error = "No instructions found in input file";
+        } else {
+            result.instructions = program.instructions.size();
+            try {
+                // The CPU takes the parsed program over instead of copying it
+                CPU cpu(make_shared<const Program>(move(program)), false, options.mode,
+                        options.config, options.backend);
+                if (options.maxCycles > 0) {
+                    cpu.setCycleLimit(options.maxCycles);
+                }
+                bool finished = cpu.execute();
+                result.status = finished ? "ok" : "cycle-limit";
+                result.cycles = cpu.getCycleCount();
+                result.retired = cpu.getInstructionCount();
+                result.registers = cpu.getRegisters();
+                result.memoryHash = memoryHash(cpu.getMemory());
+            } catch (const exception& e) {
+                result.status = "runtime-error";
+                result.error = e.what();
+            }
+        }
+    }
+
+    result.millis = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void BatchRunner::writeRecord(ostream& out, const BatchResult& result) {
+    ostringstream line;
+    line << "{\"file\":\"" << jsonEscape(result.file) << "\""
+         << ",\"status\":\"" << result.status << "\"";
+    if (!result.error.empty()) {
+        line << ",\"error\":\"" << jsonEscape(result.error) << "\"";
+    }
+    line << ",\"instructions\":" << result.instructions
+         << ",\"cycles\":" << result.cycles
+         << ",\"retired\":" << result.retired
+         << ",\"registers\":[";
+    for (size_t i = 0; i < result.registers.size(); i++) {
+        if (i) line << ",";
+        line << result.registers[i];
+    }
+    char hash[24];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(result.memoryHash));
+    char millis[32];
+    snprintf(millis, sizeof(millis), "%.3f", result.millis);
+    line << "],\"memoryHash\":\"" << hash << "\""
+         << ",\"ms\":" << millis << "}\n";
+
+    out << line.str();
+}
+
+size_t BatchRunner::run(const vector<string>& files, const BatchOptions& options, ostream& out) {
+    vector<BatchResult> results(files.size());
+    vector<bool> done(files.size(), false);
+    size_t nextToWrite = 0;
+    size_t failures = 0;
+    mutex outputLock;
+
+    {
+        ThreadPool pool(options.jobs);
+        for (size_t i = 0; i < files.size(); i++) {
+            pool.submit([&, i] {
+                BatchResult result = runOne(files[i], options);
+
+                // Records go out in input order: whoever completes the next
+                // missing record flushes every finished one after it
+                lock_guard<mutex> guard(outputLock);
+                results[i] = move(result);
+                done[i] = true;
+                while (nextToWrite < files.size() && done[nextToWrite]) {
+                    const BatchResult& ready = results[nextToWrite];
+                    writeRecord(out, ready);
+                    if (ready.status != "ok" && ready.status != "cycle-limit") failures++;
+                    results[nextToWrite] = BatchResult();
+                    nextToWrite++;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    out.flush();
+    return failures;
+}
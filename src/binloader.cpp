@@ -0,0 +1,197 @@
+#include "../include/binloader.h"
+#include "../include/machinecode.h"
+#include "../include/objfile.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// ELF32 constants and field offsets (the file is read by offset, so the host
+// byte order and struct layout never matter)
+static const uint8_t ELF_MAGIC[4] = {0x7F, 'E', 'L', 'F'};
+static const uint8_t ELFCLASS32 = 1;
+static const uint8_t ELFDATA2LSB = 1;
+static const uint8_t ELFDATA2MSB = 2;
+static const uint16_t EM_MIPS = 8;
+static const uint32_t SHT_PROGBITS = 1;
+static const uint32_t SHT_NOBITS = 8;
+static const uint32_t SHF_ALLOC = 0x2;
+static const uint32_t SHF_EXECINSTR = 0x4;
+
+static const size_t EH_SIZE = 52;
+static const size_t SH_SIZE = 40;
+
+static uint32_t read32(const uint8_t* p, ByteOrder order) {
+    if (order == ByteOrder::BIG) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+    return (uint32_t(p[3]) << 24) | (uint32_t(p[2]) << 16) | (uint32_t(p[1]) << 8) | p[0];
+}
+
+static uint16_t read16(const uint8_t* p, ByteOrder order) {
+    if (order == ByteOrder::BIG) {
+        return static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+    return static_cast<uint16_t>((p[1] << 8) | p[0]);
+}
+
+static string hexWord(uint32_t value) {
+    ostringstream out;
+    out << "0x" << std::hex << value;
+    return out.str();
+}
+
+// Decode count words starting at bytes into program
+static void decodeText(const uint8_t* bytes, size_t count, ByteOrder order, uint32_t base,
+                       Program& program) {
+    program.instructions.resize(count);
+    program.source.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t word = read32(bytes + i * 4, order);
+        Instruction& instr = program.instructions[i];
+        if (!MachineCode::decode(word, i, base, instr)) {
+            throw runtime_error("Unsupported instruction " + hexWord(word) + " at " +
+                                hexWord(base + static_cast<uint32_t>(i * 4)));
+        }
+        program.source[i].text = MachineCode::disassemble(instr, i);
+        program.source[i].line = 0;
+    }
+}
+
+bool BinaryLoader::isElf(const MappedFile& file) {
+    return file.size() >= sizeof(ELF_MAGIC) && memcmp(file.data(), ELF_MAGIC, sizeof(ELF_MAGIC)) == 0;
+}
+
+Program BinaryLoader::loadFlat(const MappedFile& file, ByteOrder order, uint32_t base) {
+    if (file.size() % 4) {
+        throw runtime_error("Invalid binary: size is not a multiple of 4 bytes");
+    }
+    Program program;
+    decodeText(file.data(), file.size() / 4, order, base, program);
+    return program;
+}
+
+Program BinaryLoader::loadElf(const MappedFile& file) {
+    const uint8_t* bytes = file.data();
+    if (file.size() < EH_SIZE || !isElf(file)) {
+        throw runtime_error("Invalid ELF file: truncated header");
+    }
+    if (bytes[4] != ELFCLASS32) {
+        throw runtime_error("Invalid ELF file: only ELF32 is supported");
+    }
+    if (bytes[5] != ELFDATA2LSB && bytes[5] != ELFDATA2MSB) {
+        throw runtime_error("Invalid ELF file: unknown byte order");
+    }
+    ByteOrder order = (bytes[5] == ELFDATA2MSB) ? ByteOrder::BIG : ByteOrder::LITTLE;
+
+    if (read16(bytes + 18, order) != EM_MIPS) {
+        throw runtime_error("Invalid ELF file: not a MIPS executable");
+    }
+    uint32_t entry = read32(bytes + 24, order);
+    uint32_t shoff = read32(bytes + 32, order);
+    uint16_t shentsize = read16(bytes + 46, order);
+    uint16_t shnum = read16(bytes + 48, order);
+    uint16_t shstrndx = read16(bytes + 50, order);
+
+    if (shentsize < SH_SIZE || shstrndx >= shnum ||
+        uint64_t(shoff) + uint64_t(shnum) * shentsize > file.size()) {
+        throw runtime_error("Invalid ELF file: bad section header table");
+    }
+
+    struct Section {
+        uint32_t name, type, flags, addr, offset, size;
+    };
+    auto section = [&](size_t index) {
+        const uint8_t* p = bytes + shoff + index * shentsize;
+        Section s = {read32(p, order), read32(p + 4, order), read32(p + 8, order),
+                     read32(p + 12, order), read32(p + 16, order), read32(p + 20, order)};
+        if (s.type != SHT_NOBITS && uint64_t(s.offset) + s.size > file.size()) {
+            throw runtime_error("Invalid ELF file: section " + to_string(index) + " out of range");
+        }
+        return s;
+    };
+
+    Section names = section(shstrndx);
+    auto name = [&](const Section& s) {
+        if (s.name >= names.size) return string();
+        const char* start = reinterpret_cast<const char*>(bytes + names.offset + s.name);
+        return string(start, strnlen(start, names.size - s.name));
+    };
+
+    Program program;
+    bool haveText = false;
+    uint32_t textAddr = 0;
+    uint32_t textSize = 0;
+
+    for (size_t i = 1; i < shnum; i++) {
+        Section s = section(i);
+        if (s.type != SHT_PROGBITS || !(s.flags & SHF_ALLOC)) continue;
+
+        if (name(s) == ".text") {
+            if (s.addr % 4 || s.size % 4) {
+                throw runtime_error("Invalid ELF file: misaligned .text");
+            }
+            decodeText(bytes + s.offset, s.size / 4, order, s.addr, program);
+            haveText = true;
+            textAddr = s.addr;
+            textSize = s.size;
+        } else if (!(s.flags & SHF_EXECINSTR)) {
+            // Data: pack bytes into words by lane, so a LW of an aligned
+            // address sees the value the target byte order implies
+            if (s.addr % 4) {
+                throw runtime_error("Invalid ELF file: misaligned section " + name(s));
+            }
+            MemorySegment segment;
+            segment.address = s.addr;
+            segment.words.resize((s.size + 3) / 4);
+            for (uint32_t w = 0; w < segment.words.size(); w++) {
+                uint8_t lanes[4] = {0, 0, 0, 0};
+                for (uint32_t b = 0; b < 4 && w * 4 + b < s.size; b++) {
+                    lanes[b] = bytes[s.offset + w * 4 + b];
+                }
+                segment.words[w] = static_cast<int32_t>(read32(lanes, order));
+            }
+            program.data.push_back(segment);
+        }
+    }
+
+    if (!haveText) {
+        throw runtime_error("Invalid ELF file: no .text section");
+    }
+    if (entry < textAddr || entry - textAddr >= textSize || entry % 4) {
+        throw runtime_error("Invalid ELF file: entry point outside .text");
+    }
+    program.entry = (entry - textAddr) / 4;
+    return program;
+}
+
+// Compiled code may put real work in the slot after a branch or jump, which
+// hardware runs before the transfer and the simulator skips when it is taken
+static void checkDelaySlots(const Program& program) {
+    const vector<Instruction>& code = program.instructions;
+    for (size_t i = 0; i < code.size(); i++) {
+        if (code[i].op != Opcode::BEQ && code[i].op != Opcode::J) continue;
+        if (i + 1 < code.size() && code[i + 1].op == Opcode::NOP) continue;
+        throw runtime_error("The delay slot after the branch at instruction " + to_string(i) +
+                            " is not a NOP; branch delay slots are not modelled "
+                            "(--no-delay-slots runs it anyway)");
+    }
+}
+
+bool BinaryLoader::loadPrebuilt(const MappedFile& file, bool flat, ByteOrder order, Program& program,
+                                bool ignoreDelaySlots) {
+    if (ObjectFile::matches(file)) {
+        program = ObjectFile::load(file);
+        return true;
+    }
+    if (isElf(file)) {
+        program = loadElf(file);
+    } else if (flat) {
+        program = loadFlat(file, order);
+    } else {
+        return false;
+    }
+    if (!ignoreDelaySlots) checkDelaySlots(program);
+    return true;
+}
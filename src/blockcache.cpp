@@ -0,0 +1,86 @@
+#include "../include/blockcache.h"
+#include "../include/translator.h"
+
+using namespace std;
+
+// Leaders are the first instruction, every BEQ/J target, and every
+// instruction following a BEQ/J. Blocks never cross a leader, so pairs are
+// fused only inside one block and a fused second half is never a block start.
+BlockCache::BlockCache(const vector<Instruction>& instructions)
+    : microOps(Translator::translate(instructions))
+    , blockEnd(instructions.size())
+    , blockIndex(instructions.size(), -1)
+{
+    vector<bool> leaders(instructions.size() + 1, false);
+    leaders[0] = true;
+    leaders[instructions.size()] = true;
+    
+    for (size_t i = 0; i < instructions.size(); i++) {
+        const Instruction& instr = instructions[i];
+        if (instr.op == Opcode::BEQ || instr.op == Opcode::J) {
+            if (instr.target < leaders.size()) {
+                leaders[instr.target] = true;
+            }
+            leaders[i + 1] = true;
+        }
+    }
+    
+    // Resolved once here, so making a block does not rescan its instructions
+    for (size_t i = instructions.size(); i-- > 0;) {
+        blockEnd[i] = leaders[i + 1] ? static_cast<uint32_t>(i + 1) : blockEnd[i + 1];
+    }
+    
+    // Fuse adjacent pairs where possible; the second half stays in the
+    // next slot because the fused handler reads its operands from there
+    fusedOps = microOps;
+    for (size_t i = 0; i < fusedOps.size(); i++) {
+        MicroOp fused;
+        if (i + 1 < fusedOps.size() && !leaders[i + 1] &&
+            Translator::fuse(microOps[i], microOps[i + 1], fused)) {
+            fusedOps[i] = fused;
+            i++;
+        }
+    }
+}
+
+BasicBlock BlockCache::buildBlock(size_t start) const {
+    BasicBlock block;
+    block.start = start;
+    
+    size_t end = blockEnd[start];
+    block.length = end - start;
+    block.ops = fusedOps.data();
+    
+    // The last instruction, or the fused pair that ends with it
+    block.last = end - 1;
+    if (block.length >= 2 && fusedOps[end - 2].width == 2) {
+        block.last = end - 2;
+    }
+    return block;
+}
+
+BasicBlock& BlockCache::lookup(size_t pc) {
+    int32_t index = blockIndex[pc];
+    if (index < 0) {
+        index = static_cast<int32_t>(blocks.size());
+        blocks.push_back(buildBlock(pc));
+        blockIndex[pc] = index;
+    }
+    return blocks[index];
+}
+
+// Every micro-op before the last one falls through, so the next pc comes
+// back from the handler as in threaded mode
+size_t BlockCache::execute(
+    const BasicBlock& block,
+    array<int32_t, 32>& registers,
+    GuestMemory& memory
+) {
+    const MicroOp* ops = block.ops;
+    const size_t last = block.last;
+    size_t pc = block.start;
+    while (pc < last) {
+        pc = ops[pc].handler(ops[pc], pc, registers, memory);
+    }
+    return ops[last].handler(ops[last], last, registers, memory);
+}
@@ -0,0 +1,137 @@
+#include "../include/cache.h"
+#include <sstream>
+
+using namespace std;
+
+static bool isPow2(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+static unsigned log2u(size_t n) {
+    unsigned bits = 0;
+    while ((static_cast<size_t>(1) << bits) < n) bits++;
+    return bits;
+}
+
+Cache::Cache(const CacheConfig& cfg)
+    : config(cfg)
+    , sets(cfg.size / (cfg.lineSize * cfg.associativity))
+    , offsetBits(log2u(cfg.lineSize))
+    , indexBits(log2u(sets))
+    , clock(0)
+    , rng(0x9E3779B9u)
+{
+    lines.resize(sets * config.associativity);
+}
+
+size_t Cache::chooseVictim(size_t base) {
+    // Prefer an empty way
+    for (size_t w = 0; w < config.associativity; w++) {
+        if (!lines[base + w].valid) return base + w;
+    }
+    
+    if (config.replacement == ReplacementPolicy::RANDOM) {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return base + rng % config.associativity;
+    }
+    
+    // LRU and FIFO both evict the oldest stamp; they differ in when it is set
+    size_t victim = base;
+    for (size_t w = 1; w < config.associativity; w++) {
+        if (lines[base + w].stamp < lines[victim].stamp) victim = base + w;
+    }
+    return victim;
+}
+
+size_t Cache::access(uint32_t address, bool write) {
+    clock++;
+    if (write) stats.writes++; else stats.reads++;
+    
+    uint32_t block = address >> offsetBits;
+    size_t set = block & (sets - 1);
+    uint32_t tag = block >> indexBits;
+    size_t base = set * config.associativity;
+    
+    for (size_t w = 0; w < config.associativity; w++) {
+        Line& line = lines[base + w];
+        if (line.valid && line.tag == tag) {
+            stats.hits++;
+            if (config.replacement == ReplacementPolicy::LRU) line.stamp = clock;
+            if (write && config.writePolicy == WritePolicy::WRITE_BACK) line.dirty = true;
+            return 0;
+        }
+    }
+    
+    stats.misses++;
+    
+    // Write-through caches do not allocate on a store miss; the store drains
+    // through the write buffer without stalling
+    if (write && config.writePolicy == WritePolicy::WRITE_THROUGH) {
+        return 0;
+    }
+    
+    Line& victim = lines[chooseVictim(base)];
+    if (victim.valid && victim.dirty) {
+        stats.writebacks++;
+    }
+    victim.valid = true;
+    victim.dirty = write;
+    victim.tag = tag;
+    victim.stamp = clock;
+    
+    return config.missLatency;
+}
+
+bool parseCacheConfig(const string& spec, CacheConfig& cfg) {
+    vector<string> fields;
+    stringstream ss(spec);
+    string field;
+    while (getline(ss, field, ':')) fields.push_back(field);
+    
+    if (fields.size() < 3 || fields.size() > 6) return false;
+    
+    CacheConfig parsed = cfg;
+    try {
+        parsed.size = stoul(fields[0]);
+        parsed.lineSize = stoul(fields[1]);
+        parsed.associativity = stoul(fields[2]);
+        if (fields.size() > 5) parsed.missLatency = stoul(fields[5]);
+    } catch (...) {
+        return false;
+    }
+    
+    if (fields.size() > 3) {
+        if (fields[3] == "lru") parsed.replacement = ReplacementPolicy::LRU;
+        else if (fields[3] == "fifo") parsed.replacement = ReplacementPolicy::FIFO;
+        else if (fields[3] == "random") parsed.replacement = ReplacementPolicy::RANDOM;
+        else return false;
+    }
+    
+    if (fields.size() > 4) {
+        if (fields[4] == "wb") parsed.writePolicy = WritePolicy::WRITE_BACK;
+        else if (fields[4] == "wt") parsed.writePolicy = WritePolicy::WRITE_THROUGH;
+        else return false;
+    }
+    
+    if (!isPow2(parsed.size) || !isPow2(parsed.lineSize) || !isPow2(parsed.associativity)
+        || parsed.lineSize < 4 || parsed.size < parsed.lineSize * parsed.associativity) {
+        return false;
+    }
+    
+    parsed.enabled = true;
+    cfg = parsed;
+    return true;
+}
+
+string cacheConfigToString(const CacheConfig& cfg) {
+    static const char* repl[] = { "lru", "fifo", "random" };
+    ostringstream out;
+    out << cfg.size << "B " << cfg.lineSize << "B/line "
+        << cfg.associativity << "-way "
+        << repl[static_cast<int>(cfg.replacement)] << " "
+        << (cfg.writePolicy == WritePolicy::WRITE_BACK ? "wb" : "wt") << " "
+        << cfg.missLatency << "cy";
+    return out.str();
+}
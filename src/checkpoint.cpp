@@ -0,0 +1,211 @@
+#include "../include/checkpoint.h"
+#include "../include/cpu.h"
+#include "../include/mappedfile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+uint64_t checkpointProgramHash(const vector<Instruction>& instructions) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    for (const Instruction& instr : instructions) {
+        mix(static_cast<uint64_t>(instr.op));
+        mix(static_cast<uint64_t>(instr.rs));
+        mix(static_cast<uint64_t>(instr.rt));
+        mix(static_cast<uint64_t>(instr.rd));
+        mix(static_cast<uint64_t>(instr.shamt));
+        mix(static_cast<uint64_t>(static_cast<uint32_t>(instr.imm)));
+        mix(static_cast<uint64_t>(instr.target));
+    }
+    return hash;
+}
+
+static const uint32_t LATCH_SIZES[4] = {
+    sizeof(IF_ID), sizeof(ID_EX), sizeof(EX_MEM), sizeof(MEM_WB)
+};
+
+void CPU::saveCheckpoint(const string& path) const {
+    vector<uint32_t> dirty;
+    for (uint32_t number : memory.touchedPages()) {
+        if (memory.isPageDirty(number)) dirty.push_back(number);
+    }
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.mode = static_cast<uint32_t>(mode);
+    header.programHash = checkpointProgramHash(instructions);
+    header.programSize = static_cast<uint32_t>(instructions.size());
+    header.pageCount = static_cast<uint32_t>(dirty.size());
+    header.pc = pc;
+    header.cycleCount = cycleCount;
+    header.instructionCount = instructionCount;
+    for (int i = 0; i < 32; i++) header.registers[i] = registers[i];
+    memcpy(header.latchSizes, LATCH_SIZES, sizeof(LATCH_SIZES));
+
+    // Page data starts on the first page boundary after the page table
+    uint64_t tableEnd = sizeof(header) + LATCH_SIZES[0] + LATCH_SIZES[1] + LATCH_SIZES[2] +
+                        LATCH_SIZES[3] + dirty.size() * sizeof(uint32_t);
+    header.dataOffset = (tableEnd + GuestMemory::PAGE_SIZE - 1) & ~uint64_t(GuestMemory::PAGE_SIZE - 1);
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Could not create checkpoint '" + path + "'");
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(&if_id), sizeof(if_id));
+    out.write(reinterpret_cast<const char*>(&id_ex), sizeof(id_ex));
+    out.write(reinterpret_cast<const char*>(&ex_mem), sizeof(ex_mem));
+    out.write(reinterpret_cast<const char*>(&mem_wb), sizeof(mem_wb));
+    out.write(reinterpret_cast<const char*>(dirty.data()), dirty.size() * sizeof(uint32_t));
+
+    vector<char> padding(header.dataOffset - tableEnd, 0);
+    out.write(padding.data(), padding.size());
+
+    for (uint32_t number : dirty) {
+        out.write(reinterpret_cast<const char*>(memory.pageData(number)), GuestMemory::PAGE_SIZE);
+    }
+
+    if (!out) {
+        throw runtime_error("Could not write checkpoint '" + path + "'");
+    }
+}
+
+void CPU::loadCheckpoint(const string& path) {
+    // Data segments are already stored by the constructor, so only execution
+    // counts as a used CPU
+    if (cycleCount != 0 || instructionCount != 0) {
+        throw runtime_error("Checkpoints can only be restored into a fresh CPU");
+    }
+
+    MappedFile file;
+    if (!file.open(path)) {
+        throw runtime_error("Could not open checkpoint '" + path + "'");
+    }
+    const string bad = "Invalid checkpoint '" + path + "': ";
+
+    CheckpointHeader header;
+    if (file.size() < sizeof(header)) {
+        throw runtime_error(bad + "file is truncated");
+    }
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error(bad + "not a checkpoint file");
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        throw runtime_error(bad + "unsupported version " + to_string(header.version));
+    }
+    if (memcmp(header.latchSizes, LATCH_SIZES, sizeof(LATCH_SIZES)) != 0) {
+        throw runtime_error(bad + "saved by an incompatible build");
+    }
+    if (header.programSize != instructions.size() ||
+        header.programHash != checkpointProgramHash(instructions)) {
+        throw runtime_error(bad + "taken from a different program");
+    }
+
+    uint64_t latchBytes = LATCH_SIZES[0] + LATCH_SIZES[1] + LATCH_SIZES[2] + LATCH_SIZES[3];
+    uint64_t tableEnd = sizeof(header) + latchBytes + uint64_t(header.pageCount) * sizeof(uint32_t);
+    if (header.pc > instructions.size() || header.dataOffset < tableEnd ||
+        header.dataOffset % GuestMemory::PAGE_SIZE != 0 ||
+        header.dataOffset + uint64_t(header.pageCount) * GuestMemory::PAGE_SIZE > file.size()) {
+        throw runtime_error(bad + "file is truncated or corrupt");
+    }
+
+    // Instructions in flight only make sense to the pipeline
+    const uint8_t* cursor = file.data() + sizeof(header);
+    IF_ID savedIfId;
+    ID_EX savedIdEx;
+    EX_MEM savedExMem;
+    MEM_WB savedMemWb;
+    memcpy(&savedIfId, cursor, sizeof(savedIfId));
+    cursor += sizeof(savedIfId);
+    memcpy(&savedIdEx, cursor, sizeof(savedIdEx));
+    cursor += sizeof(savedIdEx);
+    memcpy(&savedExMem, cursor, sizeof(savedExMem));
+    cursor += sizeof(savedExMem);
+    memcpy(&savedMemWb, cursor, sizeof(savedMemWb));
+    cursor += sizeof(savedMemWb);
+
+    // A latch feeds register numbers and PCs straight into array indexes, so a
+    // corrupt one must not be installed
+    const size_t size = instructions.size();
+    auto instrOk = [size](const Instruction& instr) {
+        return static_cast<unsigned>(instr.op) < static_cast<unsigned>(Opcode::UNKNOWN) &&
+               static_cast<unsigned>(instr.rs) < 32 && static_cast<unsigned>(instr.rt) < 32 &&
+               static_cast<unsigned>(instr.rd) < 32 && static_cast<unsigned>(instr.shamt) < 32 &&
+               instr.target <= size;
+    };
+    bool latchesOk =
+        (!savedIfId.valid || (savedIfId.pc < size && instrOk(savedIfId.instr) &&
+                              savedIfId.predictedPc <= size)) &&
+        (!savedIdEx.valid || (savedIdEx.pc < size && instrOk(savedIdEx.instr) &&
+                              static_cast<unsigned>(savedIdEx.destReg) < 32 &&
+                              savedIdEx.predictedPc <= size)) &&
+        (!savedExMem.valid || (savedExMem.pc < size && instrOk(savedExMem.instr) &&
+                               static_cast<unsigned>(savedExMem.destReg) < 32 &&
+                               savedExMem.branchTarget <= size)) &&
+        (!savedMemWb.valid || (savedMemWb.pc < size && instrOk(savedMemWb.instr) &&
+                               static_cast<unsigned>(savedMemWb.destReg) < 32));
+    if (!latchesOk) {
+        throw runtime_error(bad + "file is truncated or corrupt");
+    }
+
+    bool inFlight = savedIfId.valid || savedIdEx.valid || savedExMem.valid || savedMemWb.valid;
+    if (inFlight && mode != ExecMode::PIPELINE) {
+        throw runtime_error(bad + "has instructions in flight, restore it with --mode=pipeline");
+    }
+
+    vector<uint32_t> numbers(header.pageCount);
+    memcpy(numbers.data(), cursor, numbers.size() * sizeof(uint32_t));
+
+    // The constructor's data segment stores mark their pages dirty too, so a
+    // page the checkpoint does not carry was zero when it was saved; clear
+    // any such page this CPU already holds, the rest are replaced below
+    vector<uint32_t> saved(numbers);
+    sort(saved.begin(), saved.end());
+    vector<int32_t> zero(GuestMemory::PAGE_WORDS, 0);
+    for (uint32_t number : memory.touchedPages()) {
+        if (!binary_search(saved.begin(), saved.end(), number)) {
+            memory.writePage(number, zero.data());
+        }
+    }
+
+    // Runs of consecutive pages are mapped in one call where the backend
+    // allows it, otherwise copied out of the file view
+    size_t i = 0;
+    while (i < numbers.size()) {
+        size_t run = 1;
+        while (i + run < numbers.size() && numbers[i + run] == numbers[i] + run) run++;
+
+        uint64_t offset = header.dataOffset + uint64_t(i) * GuestMemory::PAGE_SIZE;
+        if (!memory.mapPages(numbers[i], static_cast<uint32_t>(run), file.fd(), offset)) {
+            for (size_t k = 0; k < run; k++) {
+                memory.writePage(numbers[i + k], reinterpret_cast<const int32_t*>(
+                    file.data() + offset + k * GuestMemory::PAGE_SIZE));
+            }
+        }
+        i += run;
+    }
+
+    pc = static_cast<size_t>(header.pc);
+    cycleCount = static_cast<size_t>(header.cycleCount);
+    instructionCount = static_cast<size_t>(header.instructionCount);
+    for (int r = 0; r < 32; r++) registers[r] = header.registers[r];
+    registers[0] = 0;
+    if_id = savedIfId;
+    id_ex = savedIdEx;
+    ex_mem = savedExMem;
+    mem_wb = savedMemWb;
+}
@@ -0,0 +1,108 @@
+#include "../include/counters.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+bool Counters::parseFormat(const string& text, CounterFormat& format) {
+    if (text == "json") {
+        format = CounterFormat::JSON;
+    } else if (text == "csv") {
+        format = CounterFormat::CSV;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Counts the threaded, block and jit engines do not collect are written as
+// null (JSON) or an empty value (CSV), never as a measured 0
+void Counters::writeJson(ostream& out, const PerfCounters& counters, ExecMode mode) {
+    const bool mix = counters.instructionMix;
+    out << "{\n"
+        << "  \"engine\": \"" << execModeToString(mode) << "\",\n"
+        << "  \"cycles\": " << counters.cycles << ",\n"
+        << "  \"retired\": " << counters.retired << ",\n"
+        << "  \"cpi\": " << fixed << setprecision(4) << counters.cpi() << ",\n";
+    if (mix) {
+        out << "  \"opcodes\": {";
+        for (size_t op = 0; op < OPCODE_COUNT; op++) {
+            out << (op ? ", " : "") << "\"" << opcodeToString(static_cast<Opcode>(op)) << "\": "
+                << counters.opcodes[op];
+        }
+        out << "},\n"
+            << "  \"loads\": " << counters.loads << ",\n"
+            << "  \"stores\": " << counters.stores << ",\n"
+            << "  \"branches\": {\"taken\": " << counters.branchesTaken
+            << ", \"notTaken\": " << counters.branchesNotTaken
+            << ", \"jumps\": " << counters.jumps << "},\n";
+    } else {
+        out << "  \"opcodes\": null,\n"
+            << "  \"loads\": null,\n"
+            << "  \"stores\": null,\n"
+            << "  \"branches\": null,\n";
+    }
+    out << "  \"flushes\": " << counters.flushes << ",\n"
+        << "  \"stalls\": {\"loadUse\": " << counters.loadUseStalls
+        << ", \"dataHazard\": " << counters.dataHazardStalls
+        << ", \"icache\": " << counters.icacheStalls
+        << ", \"dcache\": " << counters.dcacheStalls << "},\n"
+        << "  \"bubbles\": " << counters.bubbles << "\n"
+        << "}\n";
+}
+
+void Counters::writeCsv(ostream& out, const PerfCounters& counters, ExecMode mode) {
+    const bool mix = counters.instructionMix;
+    auto count = [mix](uint64_t value) { return mix ? to_string(value) : string(); };
+    out << "counter,value\n"
+        << "engine," << execModeToString(mode) << "\n"
+        << "cycles," << counters.cycles << "\n"
+        << "retired," << counters.retired << "\n"
+        << "cpi," << fixed << setprecision(4) << counters.cpi() << "\n";
+    for (size_t op = 0; op < OPCODE_COUNT; op++) {
+        out << "opcode." << opcodeToString(static_cast<Opcode>(op)) << ","
+            << count(counters.opcodes[op]) << "\n";
+    }
+    out << "loads," << count(counters.loads) << "\n"
+        << "stores," << count(counters.stores) << "\n"
+        << "branches.taken," << count(counters.branchesTaken) << "\n"
+        << "branches.notTaken," << count(counters.branchesNotTaken) << "\n"
+        << "branches.jumps," << count(counters.jumps) << "\n"
+        << "flushes," << counters.flushes << "\n"
+        << "stalls.loadUse," << counters.loadUseStalls << "\n"
+        << "stalls.dataHazard," << counters.dataHazardStalls << "\n"
+        << "stalls.icache," << counters.icacheStalls << "\n"
+        << "stalls.dcache," << counters.dcacheStalls << "\n"
+        << "bubbles," << counters.bubbles << "\n";
+}
+
+void Counters::report(const PerfCounters& counters, ExecMode mode, CounterFormat format,
+                      const string& path) {
+    ofstream file;
+    if (!path.empty()) {
+        file.open(path, ios::trunc);
+        if (!file) {
+            throw runtime_error("Could not create counter file '" + path + "'");
+        }
+    }
+    ostream& out = path.empty() ? cout : file;
+    if (path.empty()) {
+        out << "\n=== PERFORMANCE COUNTERS ===" << endl;
+    }
+
+    ios::fmtflags flags = out.flags();
+    if (format == CounterFormat::JSON) {
+        writeJson(out, counters, mode);
+    } else {
+        writeCsv(out, counters, mode);
+    }
+    out.flags(flags);
+    out.flush();
+
+    if (!path.empty() && !file) {
+        throw runtime_error("Could not write counter file '" + path + "'");
+    }
+}
@@ -1,8 +1,24 @@
 #include "../include/cpu.h"
 #include "stages.h"
 #include "debug.h"
+#include "translator.h"
+#include "blockcache.h"
+#include "jit.h"
+#include "predictor.h"
+#include "cache.h"
+#include "trace.h"
+#include "counters.h"
+#include "profiler.h"
+#include "hoststats.h"
+#include "report.h"
+#include "hooks.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <csetjmp>
+#include <cstdio>
+#include <sstream>
 
 using namespace std;
 
@@ -25,22 +41,84 @@ string opcodeToString(Opcode op) {
     }
 }
 
+string execModeToString(ExecMode mode) {
+    switch (mode) {
+        case ExecMode::PIPELINE:   return "pipeline";
+        case ExecMode::FUNCTIONAL: return "functional";
+        case ExecMode::THREADED:   return "threaded";
+        case ExecMode::BLOCK:      return "block";
+        case ExecMode::JIT:        return "jit";
+        default:                   return "unknown";
+    }
+}
+
+static const size_t MAX_CYCLES = 10000;
+static const size_t PROGRESS_SLICE = 1 << 16;   // Cycles between progress checks
+
 // CPU is constructed for main.cpp after successful parsing of assembly file
 // It sets the program counter pc to 0 so we start at the first instruction.
 // It sets cycleCount to 0.
 // It stores whether debug mode is on or off.
 // It resets all 32 registers to 0.
-// It allocates 1024 words of memory, all initialized to 0.
+// Memory starts empty: pages are allocated on first store and read as 0 until then.
 // It clears all four pipeline registers (IF_ID, ID_EX, EX_MEM, MEM_WB) so the pipeline starts empty.
 // This simulates 
-CPU::CPU(const Program& prog, bool debug)
-    : instructions(prog.instructions)
-    , pc(0)
+CPU::CPU(shared_ptr<const Program> prog, bool debug, ExecMode mode, const PipelineConfig& config,
+         MemoryBackend backend)
+    : program(move(prog))
+    , instructions(program->instructions)
+    , source(program->source)
+    , fetchStallRemaining(0)
+    , memStallRemaining(0)
+    , fetchCharged(false)
+    , memCharged(false)
+    , pc(program->entry)
+    , memory(backend)
     , cycleCount(0)
+    , instructionCount(0)
+    , counterFormat(CounterFormat::NONE)
+    , outputFormat(OutputFormat::TEXT)
     , debugMode(debug)
+    , mode(mode)
+    , config(config)
+    , cycleLimit(MAX_CYCLES)
+    , tracer(nullptr)
+    , profiler(nullptr)
+    , hostStats(nullptr)
+    , hooks(nullptr)
+    , logPolicy(LogPolicy::BLOCK)
+    , logCapacity(AsyncWriter<DebugSnapshot>::DEFAULT_CAPACITY)
 {
     registers.fill(0);
-    memory.resize(1024, 0);
+    
+    // Initialised data of loaded binaries (all-zero words stay untouched)
+    for (const MemorySegment& segment : program->data) {
+        for (size_t i = 0; i < segment.words.size(); i++) {
+            if (segment.words[i] != 0) {
+                memory.store(segment.address + static_cast<uint32_t>(i * 4), segment.words[i]);
+            }
+        }
+    }
+
+    // Threaded mode decodes the whole program once, up front
+    if (mode == ExecMode::THREADED) {
+        microOps = Translator::translate(instructions);
+    }
+    // Block mode also translates up front and splits basic blocks on first use
+    if (mode == ExecMode::BLOCK || mode == ExecMode::JIT) {
+        blockCache.reset(new BlockCache(instructions));
+    }
+    // The pipeline consults a branch predictor at fetch
+    if (mode == ExecMode::PIPELINE) {
+        predictor = BranchPredictor::create(config.predictor, config.predictorSize);
+        branchStats.resize(instructions.size());
+        if (config.icache.enabled) icache.reset(new Cache(config.icache));
+        if (config.dcache.enabled) dcache.reset(new Cache(config.dcache));
+    }
+    // JIT mode also compiles hot blocks; cold code stays interpreted
+    if (mode == ExecMode::JIT && JitCompiler::available()) {
+        jit.reset(new JitCompiler(instructions.size(), memory.getFlatBase()));
+    }
 
     if_id = IF_ID();
     id_ex = ID_EX();
@@ -48,6 +126,12 @@ CPU::CPU(const Program& prog, bool debug)
     mem_wb = MEM_WB();
 }
 
+CPU::CPU(const Program& prog, bool debug, ExecMode mode, const PipelineConfig& config,
+         MemoryBackend backend)
+    : CPU(make_shared<const Program>(prog), debug, mode, config, backend) {}
+
+CPU::~CPU() = default;
+
 // CPU helper functions that delegate to PipelineStages
 // generateControl and executeALU forward the work to PipelineStages in stages.cpp
 ControlSignals CPU::generateControl(const Instruction& instr) {
@@ -70,37 +154,122 @@ void CPU::stepPipeline() {
     EX_MEM next_ex_mem;
     MEM_WB next_mem_wb;
 
+    // Host timing on sampled cycles only
+    HostStats* timer = (hostStats && hostStats->sampling(cycleCount)) ? hostStats : nullptr;
+    if (timer) timer->startSample();
+
+    // Data cache: a miss on the access now in EX/MEM freezes every stage
+    // until the line arrives
+    if (dcache && ex_mem.valid && (ex_mem.ctrl.memRead || ex_mem.ctrl.memWrite) && !memCharged) {
+        memStallRemaining = dcache->access(static_cast<uint32_t>(ex_mem.aluResult),
+                                           ex_mem.ctrl.memWrite);
+        memCharged = true;
+    }
+    if (memStallRemaining > 0) {
+        memStallRemaining--;
+        stalls.dcacheMiss++;
+        if (timer) timer->mark(HOST_MEM);
+        return;
+    }
+    memCharged = false;
+
     // // If the instruction needs to write to a register (like an ADD or LW), 
     // WB takes the ALU result or memory data and writes it into the register file.
-    PipelineStages::wbStage(mem_wb, registers);
+    if (mem_wb.valid) instructionCount++;
+    PipelineStages::wbStage(mem_wb, registers, counters);
+    if (timer) timer->mark(HOST_WB);
 
     // If the instruction needs to read or write memory (like LW or SW),
     // it (LW) reads from memory or (SW) writes to memory through
-    next_mem_wb = PipelineStages::memStage(ex_mem, memory);
+    next_mem_wb = PipelineStages::memStage(ex_mem, memory, counters);
+    if (timer) timer->mark(HOST_MEM);
 
     // EX Stage performs arthmetic/logical operations
     // Computes the address for load/store instructions
     // Checks (BEQ) branch and (J) jumps whether to change the PC or not 
+    // With forwarding on, the operands are first patched from EX/MEM and MEM/WB
     bool branchTaken = false;
     size_t branchTarget = 0;
-    next_ex_mem = PipelineStages::exStage(id_ex, branchTaken, branchTarget);
+    if (config.forwarding) {
+        ID_EX forwarded = id_ex;
+        PipelineStages::forward(forwarded, ex_mem, mem_wb);
+        next_ex_mem = PipelineStages::exStage(forwarded, branchTaken, branchTarget, counters);
+    } else {
+        next_ex_mem = PipelineStages::exStage(id_ex, branchTaken, branchTarget, counters);
+    }
+    if (timer) timer->mark(HOST_EX);
 
-    // Decode stage
-    next_id_ex = PipelineStages::idStage(if_id, registers);
+    // Hazard detection: hold IF/ID and the PC, and send a bubble down to EX
+    StallCause stall = StallCause::NONE;
+    if (config.hazardDetection) {
+        stall = PipelineStages::detectHazard(if_id, id_ex, ex_mem, config.forwarding);
+    }
+
+    if (stall != StallCause::NONE) {
+        next_id_ex = ID_EX();   // bubble
+        next_if_id = if_id;     // hold
+        if (timer) timer->mark(HOST_ID);
+    } else {
+        // Decode stage
+        next_id_ex = PipelineStages::idStage(if_id, registers);
+        if (timer) timer->mark(HOST_ID);
 
-    // If the PC is still within the program ranges
-    if (pc < instructions.size()) {
-        next_if_id.valid = true;
-        next_if_id.pc = pc;
-        next_if_id.instr = instructions[pc];
-        pc++;
+        // If the PC is still within the program ranges
+        // Branches and jumps ask the predictor where to fetch next
+        // On an I-cache miss the fetch stage sends bubbles until the line arrives
+        if (icache && pc < instructions.size() && !fetchCharged) {
+            fetchStallRemaining = icache->access(static_cast<uint32_t>(pc * 4), false);
+            fetchCharged = true;
+        }
+        if (fetchStallRemaining > 0) {
+            fetchStallRemaining--;
+            stalls.icacheMiss++;
+        } else if (pc < instructions.size()) {
+            fetchCharged = false;
+            const Instruction& fetched = instructions[pc];
+            size_t nextPc = pc + 1;
+            size_t predictorIndex = 0;
+            if (fetched.op == Opcode::BEQ || fetched.op == Opcode::J) {
+                nextPc = predictor->predict(pc, fetched, predictorIndex);
+            }
+            next_if_id.valid = true;
+            next_if_id.pc = pc;
+            next_if_id.instr = fetched;
+            next_if_id.predictedPc = nextPc;
+            next_if_id.predictorIndex = predictorIndex;
+            pc = nextPc;
+        }
+        if (timer) timer->mark(HOST_IF);
     }
 
-    // Branch / Jump handling 
-    if (branchTaken) {
+    // Branch / Jump resolution: train the predictor and check the fetch-time guess
+    bool mispredicted = false;
+    size_t actualPc = 0;
+    if (id_ex.valid && (id_ex.instr.op == Opcode::BEQ || id_ex.instr.op == Opcode::J)) {
+        actualPc = branchTaken ? branchTarget : id_ex.pc + 1;
+        predictor->update(id_ex.pc, id_ex.instr, branchTaken, branchTarget, id_ex.predictorIndex);
+
+        BranchStats& stats = branchStats[id_ex.pc];
+        stats.executed++;
+        if (branchTaken) stats.taken++;
+        if (actualPc != id_ex.predictedPc) {
+            stats.mispredicted++;
+            mispredicted = true;
+        }
+    }
+
+    if (mispredicted) {
         next_if_id = IF_ID();   // flush
         next_id_ex = ID_EX();   // flush
-        pc = branchTarget;      // redirect PC
+        pc = actualPc;          // redirect PC
+        stalls.flushes++;
+        // Abandon any fetch still waiting on the I-cache for the wrong path
+        fetchStallRemaining = 0;
+        fetchCharged = false;
+    } else if (stall == StallCause::LOAD_USE) {
+        stalls.loadUse++;
+    } else if (stall == StallCause::DATA_HAZARD) {
+        stalls.dataHazard++;
     }
 
     // Update pipeline registers
@@ -111,32 +280,526 @@ void CPU::stepPipeline() {
 
     // Enforce $zero = 0
     registers[0] = 0;
+    if (timer) timer->mark(HOST_RESOLVE);
+}
+// stepFunctional executes one whole instruction with no pipeline registers.
+// Uses the same control, ALU and memory helpers as the pipeline stages, so the
+// final architectural state matches the pipelined model for hazard-free code.
+void CPU::stepFunctional() {
+    const Instruction& instr = instructions[pc];
+    ControlSignals ctrl = PipelineStages::generateControl(instr);
+
+    int32_t rsVal = registers[instr.rs];
+    int32_t rtVal = registers[instr.rt];
+    int32_t aluOp2 = ctrl.aluSrc ? PipelineStages::signExtend(instr.imm) : rtVal;
+    int32_t aluResult = PipelineStages::executeALU(instr, rsVal, aluOp2);
+
+    size_t nextPc = pc + 1;
+    if (instr.op == Opcode::BEQ) {
+        if (rsVal == rtVal) {
+            nextPc = instr.target;
+            counters.branchesTaken++;
+        } else {
+            counters.branchesNotTaken++;
+        }
+    } else if (instr.op == Opcode::J) {
+        nextPc = instr.target;
+        counters.jumps++;
+    }
+
+    int32_t value = aluResult;
+    if (ctrl.memRead) {
+        value = PipelineStages::loadWord(memory, aluResult);
+        counters.loads++;
+    } else if (ctrl.memWrite) {
+        PipelineStages::storeWord(memory, aluResult, rtVal);
+        counters.stores++;
+    }
+    counters.opcodes[static_cast<size_t>(instr.op)]++;
+
+    if (ctrl.regWrite) {
+        int destReg = ctrl.regDst ? instr.rd : instr.rt;
+        registers[destReg] = value;
+    }
+
+    // Enforce $zero = 0
+    registers[0] = 0;
+    pc = nextPc;
+    instructionCount++;
+}
+
+// stepThreaded dispatches one pre-decoded micro-op through its handler
+void CPU::stepThreaded() {
+    const MicroOp& uop = microOps[pc];
+    pc = uop.handler(uop, pc, registers, memory);
+    instructionCount++;
+}
+
+// stepBlock runs a whole basic block per dispatch
+// Cycle and instruction counters are bumped once for the block
+void CPU::stepBlock() {
+    BasicBlock& block = blockCache->lookup(pc);
+
+    if (jit && !block.native && ++block.hits == JitCompiler::HOT_THRESHOLD) {
+        block.native = jit->compile(block, blockCache->getMicroOps());
+    }
+
+    if (block.native) {
+        int64_t budget = 1;   // Just this block, no chaining
+        pc = jit->run(block.native, registers.data(), &memory, budget);
+    } else {
+        pc = BlockCache::execute(block, registers, memory);
+    }
+
+    cycleCount += block.length;
+    instructionCount += block.length;
+}
+
+// Event counts plus the totals the CPU already keeps
+PerfCounters CPU::getCounters() const {
+    PerfCounters result = counters;
+    result.cycles = cycleCount;
+    result.retired = instructionCount;
+    result.flushes = stalls.flushes;
+    result.loadUseStalls = stalls.loadUse;
+    result.dataHazardStalls = stalls.dataHazard;
+    result.icacheStalls = stalls.icacheMiss;
+    result.dcacheStalls = stalls.dcacheMiss;
+    result.instructionMix = (mode == ExecMode::PIPELINE || mode == ExecMode::FUNCTIONAL);
+    return result;
 }
+
+bool CPU::finished() const {
+    if (mode != ExecMode::PIPELINE) {
+        return pc >= instructions.size();
+    }
+    return pc >= instructions.size() && pipelineEmpty();
+}
+
+// step advances the selected engine by one cycle (pipeline), one instruction
+// (functional, threaded) or one basic block (block, jit)
+void CPU::step() {
+    if (mode == ExecMode::BLOCK || mode == ExecMode::JIT) {
+        stepBlock();
+        return;
+    }
+
+    cycleCount++;
+    if (mode == ExecMode::THREADED) {
+        stepThreaded();
+    } else if (mode == ExecMode::FUNCTIONAL) {
+        stepFunctional();
+    } else {
+        stepPipeline();
+    }
+}
+
+// runLoop is the simulation loop shared by run(), execute() and advance()
+// It stops when the program finishes, cycleCount reaches stopCycle or until
+// (if given) returns true
+// With a debug log, the debug state is snapshotted after every step and
+// printed by the log's writer thread
+bool CPU::runLoop(AsyncWriter<DebugSnapshot>* debugLog, size_t stopCycle,
+                  StopCheck until, void* context) {
+    if (debugLog || tracer || profiler || hooks || until) {
+        while (!finished() && cycleCount < stopCycle) {
+            if (until && until(context)) break;
+            size_t fetchPc = pc;
+            if (profiler) {
+                profiledStep();
+            } else {
+                observedStep();
+            }
+
+            if (debugLog) {
+                const bool timed = hostStats && hostStats->sampling(cycleCount);
+                const uint64_t start = timed ? HostStats::now() : 0;
+                DebugSnapshot snapshot;
+                Debug::capture(*this, fetchPc, snapshot);
+                debugLog->push(snapshot);
+                if (timed) hostStats->addDebugSample(HostStats::now() - start);
+            }
+        }
+        return finished();
+    }
+
+    // Threaded mode gets its own tight dispatch loop
+    if (mode == ExecMode::THREADED) {
+        const size_t count = microOps.size();
+        const MicroOp* uops = microOps.data();
+        size_t limit = stopCycle > cycleCount ? stopCycle - cycleCount : 0;
+        size_t executed = 0;
+        while (pc < count && executed < limit) {
+            const MicroOp& uop = uops[pc];
+            pc = uop.handler(uop, pc, registers, memory);
+            executed++;
+        }
+        cycleCount += executed;
+        instructionCount += executed;
+        return finished();
+    }
+
+    // JIT mode runs compiled code, which chains from block to block on its
+    // own, and interprets the blocks in between until they turn hot
+    if (jit && !finished() && cycleCount < stopCycle) {
+        const size_t count = blockCache->programSize();
+        const int64_t limit = static_cast<int64_t>(
+            min<size_t>(stopCycle - cycleCount, static_cast<size_t>(INT64_MAX)));
+        int64_t budget = limit;
+        size_t next = pc;
+        BasicBlock* block = &blockCache->lookup(next);
+        for (;;) {
+            if (!block->native && ++block->hits == JitCompiler::HOT_THRESHOLD) {
+                block->native = jit->compile(*block, blockCache->getMicroOps());
+            }
+            if (block->native) {
+                // Stops at some later block, whose successor links are not known
+                next = jit->run(block->native, registers.data(), &memory, budget);
+                if (next >= count || budget <= 0) break;
+                block = &blockCache->lookup(next);
+            } else {
+                next = BlockCache::execute(*block, registers, memory);
+                budget -= static_cast<int64_t>(block->length);
+                if (next >= count || budget <= 0) break;
+                block = &blockCache->successor(*block, next);
+            }
+        }
+        pc = next;
+        cycleCount += static_cast<size_t>(limit - budget);
+        instructionCount += static_cast<size_t>(limit - budget);
+        return finished();
+    }
+
+    // Block mode follows each block's cached successor links, so the steady
+    // state does no lookup; a block runs to its end even past stopCycle
+    if ((mode == ExecMode::BLOCK || mode == ExecMode::JIT) && !finished() &&
+        cycleCount < stopCycle) {
+        const size_t count = blockCache->programSize();
+        size_t limit = stopCycle - cycleCount;
+        size_t executed = 0;
+        size_t next = pc;
+        BasicBlock* block = &blockCache->lookup(next);
+        for (;;) {
+            // BlockCache::execute, inlined to keep the dispatch in registers
+            const MicroOp* ops = block->ops;
+            const size_t last = block->last;
+            next = block->start;
+            while (next < last) {
+                next = ops[next].handler(ops[next], next, registers, memory);
+            }
+            next = ops[last].handler(ops[last], last, registers, memory);
+            executed += block->length;
+            if (next >= count || executed >= limit) break;
+            block = &blockCache->successor(*block, next);
+        }
+        pc = next;
+        cycleCount += executed;
+        instructionCount += executed;
+        return finished();
+    }
+
+    while (!finished() && cycleCount < stopCycle) {
+        step();
+    }
+    return finished();
+}
+
+// recordStep runs step() and records what it did. The pipeline record is
+// rebuilt from the latches: the old MEM/WB retired, the old EX/MEM accessed
+// memory and the old ID/EX resolved any branch, unless the D-cache froze the
+// whole cycle.
+void CPU::recordStep(TraceRecord& record) {
+    if (mode == ExecMode::PIPELINE) {
+        const ID_EX oldIdEx = id_ex;
+        const EX_MEM oldExMem = ex_mem;
+        const MEM_WB oldMemWb = mem_wb;
+        const size_t frozen = stalls.dcacheMiss;
+        const size_t flushes = stalls.flushes;
+
+        guardedStep();
+
+        if (if_id.valid) record.setStage(TRACE_IF, static_cast<uint32_t>(if_id.pc));
+        if (id_ex.valid) record.setStage(TRACE_ID, static_cast<uint32_t>(id_ex.pc));
+        if (ex_mem.valid) record.setStage(TRACE_EX, static_cast<uint32_t>(ex_mem.pc));
+        if (mem_wb.valid) record.setStage(TRACE_MEM, static_cast<uint32_t>(mem_wb.pc));
+
+        if (stalls.dcacheMiss != frozen) {
+            record.flags |= TRACE_STALL;
+        } else {
+            if (oldMemWb.valid) {
+                record.setStage(TRACE_WB, static_cast<uint32_t>(oldMemWb.pc));
+                if (oldMemWb.ctrl.regWrite && oldMemWb.destReg != 0) {
+                    record.flags |= TRACE_REG_WRITE;
+                    record.reg = static_cast<uint8_t>(oldMemWb.destReg);
+                    record.regValue = registers[oldMemWb.destReg];
+                }
+            }
+            if (oldExMem.valid && (oldExMem.ctrl.memRead || oldExMem.ctrl.memWrite)) {
+                record.flags |= oldExMem.ctrl.memRead ? TRACE_MEM_READ : TRACE_MEM_WRITE;
+                record.memAddress = static_cast<uint32_t>(oldExMem.aluResult);
+                record.memValue = oldExMem.ctrl.memRead ? mem_wb.memReadData : oldExMem.rtVal;
+            }
+            if (oldIdEx.valid && (oldIdEx.instr.op == Opcode::BEQ || oldIdEx.instr.op == Opcode::J)) {
+                record.flags |= TRACE_BRANCH;
+                record.branchPc = static_cast<uint32_t>(oldIdEx.pc);
+                if (ex_mem.branchTaken) record.flags |= TRACE_TAKEN;
+                if (stalls.flushes != flushes) record.flags |= TRACE_MISPREDICT;
+            }
+        }
+    } else {
+        // One instruction per step: everything happens at the executed PC
+        const size_t executed = pc;
+        const Instruction& instr = instructions[executed];
+        const ControlSignals ctrl = PipelineStages::generateControl(instr);
+        const int32_t rtVal = registers[instr.rt];
+        const int32_t address = PipelineStages::executeALU(
+            instr, registers[instr.rs], PipelineStages::signExtend(instr.imm));
+
+        guardedStep();
+
+        record.setStage(TRACE_WB, static_cast<uint32_t>(executed));
+        int destReg = ctrl.regDst ? instr.rd : instr.rt;
+        if (ctrl.regWrite && destReg != 0) {
+            record.flags |= TRACE_REG_WRITE;
+            record.reg = static_cast<uint8_t>(destReg);
+            record.regValue = registers[destReg];
+        }
+        if (ctrl.memRead || ctrl.memWrite) {
+            record.flags |= ctrl.memRead ? TRACE_MEM_READ : TRACE_MEM_WRITE;
+            record.memAddress = static_cast<uint32_t>(address);
+            record.memValue = ctrl.memRead ? PipelineStages::loadWord(memory, address) : rtVal;
+        }
+        if (instr.op == Opcode::BEQ || instr.op == Opcode::J) {
+            record.flags |= TRACE_BRANCH;
+            record.branchPc = static_cast<uint32_t>(executed);
+            if (instr.op == Opcode::J || registers[instr.rs] == registers[instr.rt]) {
+                record.flags |= TRACE_TAKEN;
+            }
+        }
+    }
+
+    record.cycle = cycleCount;
+}
+
+// observedStep runs one step for the tracer and the hooks, whichever are set
+void CPU::observedStep() {
+    if (!tracer && !hooks) {
+        guardedStep();
+        return;
+    }
+
+    const size_t fetchPc = pc;
+    const StallStats before = stalls;
+    TraceRecord record;
+    recordStep(record);
+    if (tracer) tracer->write(record);
+    if (hooks) callHooks(record, fetchPc, before);
+}
+
+// A pipeline cycle fetched unless a stall of any kind held the fetch stage;
+// the functional engines fetch the instruction they execute
+void CPU::callHooks(const TraceRecord& record, size_t fetchPc, const StallStats& before) {
+    const bool pipelined = mode == ExecMode::PIPELINE;
+    bool fetched = fetchPc < instructions.size();
+    if (pipelined) {
+        fetched = fetched && stalls.dcacheMiss == before.dcacheMiss &&
+                  stalls.icacheMiss == before.icacheMiss && stalls.loadUse == before.loadUse &&
+                  stalls.dataHazard == before.dataHazard;
+    }
+    if (fetched) {
+        hooks->onFetch(fetchPc);
+    }
+
+    // The access belongs to the instruction now in MEM/WB (pipeline) or the
+    // one just executed
+    if (record.flags & (TRACE_MEM_READ | TRACE_MEM_WRITE)) {
+        hooks->onMemory(record.stagePc[pipelined ? TRACE_MEM : TRACE_WB], record.memAddress,
+                        record.memValue, (record.flags & TRACE_MEM_WRITE) != 0);
+    }
+    if (record.hasStage(TRACE_WB)) {
+        const size_t retired = record.stagePc[TRACE_WB];
+        hooks->onRetire(retired, instructions[retired]);
+    }
+}
+
+// profiledStep runs one (traced) step and charges its cycle, stalls and any
+// flush to the instructions responsible, following the rules in profiler.h
+void CPU::profiledStep() {
+    if (mode != ExecMode::PIPELINE) {
+        const size_t executed = pc;
+        observedStep();
+        profiler->chargeCycle(executed, true);
+        return;
+    }
+
+    PipelineStep record;
+    record.valid[0] = if_id.valid;
+    record.latchPc[0] = if_id.pc;
+    record.valid[1] = id_ex.valid;
+    record.latchPc[1] = id_ex.pc;
+    record.valid[2] = ex_mem.valid;
+    record.latchPc[2] = ex_mem.pc;
+    record.valid[3] = mem_wb.valid;
+    record.latchPc[3] = mem_wb.pc;
+    record.fetchPc = pc;
+    const StallStats before = stalls;
+
+    observedStep();
+
+    record.frozen = stalls.dcacheMiss != before.dcacheMiss;
+    record.hazardStalls = (stalls.loadUse - before.loadUse) + (stalls.dataHazard - before.dataHazard);
+    record.icacheStall = stalls.icacheMiss != before.icacheMiss;
+    record.flushed = stalls.flushes != before.flushes;
+    profiler->chargePipeline(record);
+}
+
+// runGuarded arms the flat-memory fault scope, so a page that cannot be
+// committed becomes a runtime error instead of a crash. The fault handler
+// siglongjmps out of the guest access and skips every destructor on the way,
+// so only the engine itself (step() and the stage functions, interpreters
+// and native code under it, none of which own resources) may run inside a
+// scope. The plain loop is guarded as a whole. The observed loop calls out
+// to the debug log, tracer, profiler, hooks and stop predicate, so there
+// each step is guarded on its own (guardedStep) and those run outside.
+bool CPU::runGuarded(AsyncWriter<DebugSnapshot>* debugLog, size_t stopCycle,
+                     StopCheck until, void* context) {
+    const bool observed = debugLog || tracer || profiler || hooks || until;
+    if (!memory.isFlat() || observed) {
+        return runLoop(debugLog, stopCycle, until, context);
+    }
+
+    GuestMemory::FaultScope scope;
+    if (sigsetjmp(scope.env, 1) != 0) {
+        throw runtime_error("Memory access fault at address " +
+                            to_string(GuestMemory::lastFaultAddress()));
+    }
+    return runLoop(debugLog, stopCycle, until, context);
+}
+
+// One step inside its own fault scope (flat memory only). The handler is
+// installed with SA_NODEFER, so SIGSEGV is not blocked when it jumps back
+// and the signal mask does not need saving
+void CPU::guardedStep() {
+    if (!memory.isFlat()) {
+        step();
+        return;
+    }
+
+    GuestMemory::FaultScope scope;
+    if (sigsetjmp(scope.env, 0) != 0) {
+        throw runtime_error("Memory access fault at address " +
+                            to_string(GuestMemory::lastFaultAddress()));
+    }
+    step();
+}
+
+bool CPU::execute() {
+    return runGuarded(nullptr, cycleLimit);
+}
+
+// current + cycles, capped at limit without overflowing
+static size_t stopAfter(size_t current, size_t cycles, size_t limit) {
+    return (current >= limit || cycles >= limit - current) ? limit : current + cycles;
+}
+
+bool CPU::advance(size_t cycles) {
+    return runGuarded(nullptr, stopAfter(cycleCount, cycles, cycleLimit));
+}
+
+bool CPU::advanceUntil(StopCheck until, void* context, size_t cycles) {
+    return runGuarded(nullptr, stopAfter(cycleCount, cycles, cycleLimit), until, context);
+}
+
 // Main simulation loop that runs until all instructions complete
 // Shows each instruction’s binary + assembly (and debug info if enabled)
 void CPU::run() {
-    cout << "\n=== STARTING SIMULATION ===" << endl;
-
-    Debug::printBinaryRepresentation(instructions);
+    // Structured output replaces every formatted table with one report
+    const bool tables = outputFormat == OutputFormat::TEXT;
+    if (tables) {
+        cout << "\n=== STARTING SIMULATION ===" << endl;
+        Debug::printBinaryRepresentation(instructions, source);
+    }
 
-    const size_t MAX_CYCLES = 10000;
+    // Debug output is formatted and written on its own thread, in large
+    // batches, so the cycle loop never waits on the terminal or a pipe
+    // (unless the queue fills up under LogPolicy::BLOCK)
+    unique_ptr<AsyncWriter<DebugSnapshot>> debugLog;
+    if (debugMode) {
+        cout.flush();
+        const vector<SourceLine>& text = source;
+        auto formatted = make_shared<ostringstream>();
+        HostStats* host = hostStats;
+        debugLog.reset(new AsyncWriter<DebugSnapshot>(
+            [&text, formatted, host](const DebugSnapshot& snapshot, string& out) {
+                const uint64_t start = host ? HostStats::now() : 0;
+                formatted->str("");
+                Debug::printState(snapshot, text, *formatted);
+                out += formatted->str();
+                if (host) host->addFormatTicks(HostStats::now() - start);
+            },
+            [](const char* data, size_t size) {
+                fwrite(data, 1, size, stdout);
+                fflush(stdout);
+            },
+            logPolicy, logCapacity));
+    }
 
-    while ((pc < instructions.size() || !pipelineEmpty()) && cycleCount < MAX_CYCLES) {
-        cycleCount++;
-        stepPipeline();
+    if (hostStats) {
+        hostStats->begin(cycleCount, instructionCount);
+    }
+    if (hostStats && hostStats->progressEnabled()) {
+        // Run in slices so the progress line can be refreshed between them
+        while (!runGuarded(debugLog.get(), min(cycleCount + PROGRESS_SLICE, cycleLimit)) &&
+               cycleCount < cycleLimit) {
+            hostStats->progress(cycleCount, instructionCount);
+        }
+    } else {
+        runGuarded(debugLog.get(), cycleLimit);
+    }
 
-        if (debugMode) {
-            Debug::printPipelineState(*this);
+    if (debugLog) {
+        debugLog->close();
+        if (debugLog->droppedCount() > 0) {
+            cerr << "\nWarning: " << debugLog->droppedCount()
+                 << " debug records dropped (queue full)" << endl;
         }
     }
+    // After the writer thread is joined, so its formatting time is complete
+    if (hostStats) {
+        hostStats->end(cycleCount, instructionCount);
+    }
 
-    if (cycleCount >= MAX_CYCLES) {
-        cerr << "\nWarning: Simulation stopped after " << MAX_CYCLES
+    if (cycleCount >= cycleLimit) {
+        cerr << "\nWarning: Simulation stopped after " << cycleLimit
              << " cycles" << endl;
     }
 
+    if (!tables) {
+        cout.flush();
+        StateReport::write(*this, outputFormat, stdout);
+    } else {
+        printFinalState();
+    }
+
+    if (counterFormat != CounterFormat::NONE) {
+        Counters::report(getCounters(), mode, counterFormat, counterPath);
+    }
+}
+
+void CPU::printFinalState() const {
     cout << "\n=== FINAL MACHINE STATE ===" << endl;
-    cout << "Total Cycles: " << cycleCount << endl;
+    if (mode != ExecMode::PIPELINE) {
+        cout << "Instructions Executed: " << instructionCount << endl;
+    } else {
+        cout << "Total Cycles: " << cycleCount << endl;
+    }
+    if (mode == ExecMode::PIPELINE && config.reportStats) {
+        Debug::printStallStats(*this);
+        Debug::printBranchStats(*this);
+    }
+    if (icache || dcache) {
+        Debug::printCacheStats(*this);
+    }
     Debug::printRegisters(registers);
     Debug::printMemory(memory);
 }
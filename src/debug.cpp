@@ -1,8 +1,12 @@
 #include "../include/debug.h"
+#include "../include/predictor.h"
+#include "../include/cache.h"
+#include "../include/machinecode.h"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
 #include <bitset>
+#include <algorithm>
 
 using namespace std;
 
@@ -19,40 +23,52 @@ string Debug::regName(int reg) {
     return "$??";
 }
 
-void Debug::printRegisters(const std::array<int32_t, 32>& registers) {
-    std::cout << "\n--- Register File ---\n";
+const string& Debug::sourceText(const std::vector<SourceLine>& source, size_t pc) {
+    static const string unknown = "??";
+    if (pc < source.size()) return source[pc].text;
+    return unknown;
+}
+
+void Debug::printRegisters(const std::array<int32_t, 32>& registers, std::ostream& out) {
+    out << "\n--- Register File ---\n";
     bool found = false;
     
     for (int i = 0; i < 32; i++) {
         if (registers[i] != 0) {
-            std::cout << std::setw(6) << regName(i) << " ($" << std::setw(2) << i << "): "
-                      << std::setw(11) << registers[i];
+            out << std::setw(6) << regName(i) << " ($" << std::setw(2) << i << "): "
+                << std::setw(11) << registers[i];
             
             // Print hex value
-            std::cout << "  (0x" << std::hex << std::setfill('0') 
-                      << std::setw(8) << static_cast<uint32_t>(registers[i])
-                      << std::dec << std::setfill(' ') << ")\n";
+            out << "  (0x" << std::hex << std::setfill('0') 
+                << std::setw(8) << static_cast<uint32_t>(registers[i])
+                << std::dec << std::setfill(' ') << ")\n";
             found = true;
         }
     }
     
     if (!found) {
-        std::cout << "  (all registers are zero)\n";
+        out << "  (all registers are zero)\n";
     }
 }
 
-void Debug::printMemory(const std::vector<int32_t>& memory) {
+void Debug::printMemory(const GuestMemory& memory) {
     std::cout << "\n--- Memory (non-zero) ---\n";
     bool found = false;
     
-    for (size_t i = 0; i < memory.size(); i++) {
-        if (memory[i] != 0) {
-            std::cout << "  [" << std::setw(4) << (i * 4) << "]: "
-                      << std::setw(11) << memory[i]
-                      << "  (0x" << std::hex << std::setfill('0')
-                      << std::setw(8) << static_cast<uint32_t>(memory[i])
-                      << std::dec << std::setfill(' ') << ")\n";
-            found = true;
+    // Only pages that were ever touched can hold non-zero words
+    for (uint32_t number : memory.touchedPages()) {
+        const int32_t* words = memory.pageData(number);
+        uint32_t base = number << GuestMemory::PAGE_BITS;
+        for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS; i++) {
+            int32_t value = words[i];
+            if (value != 0) {
+                std::cout << "  [" << std::setw(4) << (base + i * 4) << "]: "
+                          << std::setw(11) << value
+                          << "  (0x" << std::hex << std::setfill('0')
+                          << std::setw(8) << static_cast<uint32_t>(value)
+                          << std::dec << std::setfill(' ') << ")\n";
+                found = true;
+            }
         }
     }
     
@@ -61,157 +77,243 @@ void Debug::printMemory(const std::vector<int32_t>& memory) {
     }
 }
 
-void Debug::printControlSignals(const ControlSignals& ctrl) {
-    std::cout << "    RegDst=" << ctrl.regDst
-              << " ALUSrc=" << ctrl.aluSrc
-              << " MemToReg=" << ctrl.memToReg
-              << " RegWrite=" << ctrl.regWrite
-              << " MemRead=" << ctrl.memRead
-              << " MemWrite=" << ctrl.memWrite
-              << " Branch=" << ctrl.branch
-              << " Jump=" << ctrl.jump << "\n";
+void Debug::printControlSignals(const ControlSignals& ctrl, std::ostream& out) {
+    out << "    RegDst=" << ctrl.regDst
+        << " ALUSrc=" << ctrl.aluSrc
+        << " MemToReg=" << ctrl.memToReg
+        << " RegWrite=" << ctrl.regWrite
+        << " MemRead=" << ctrl.memRead
+        << " MemWrite=" << ctrl.memWrite
+        << " Branch=" << ctrl.branch
+        << " Jump=" << ctrl.jump << "\n";
 }
 
-void Debug::printIF_ID(const IF_ID& reg) {
-    std::cout << "  IF/ID: ";
+void Debug::printIF_ID(const IF_ID& reg, const std::vector<SourceLine>& source, std::ostream& out) {
+    out << "  IF/ID: ";
     if (reg.valid) {
-        std::cout << "[" << reg.instr.text << "]\n";
-        std::cout << "    PC=" << reg.pc << "\n";
+        out << "[" << sourceText(source, reg.pc) << "]\n";
+        out << "    PC=" << reg.pc << "\n";
     } else {
-        std::cout << "[empty]\n";
+        out << "[empty]\n";
     }
 }
 
-void Debug::printID_EX(const ID_EX& reg) {
-    std::cout << "  ID/EX: ";
+void Debug::printID_EX(const ID_EX& reg, const std::vector<SourceLine>& source, std::ostream& out) {
+    out << "  ID/EX: ";
     if (reg.valid) {
-        std::cout << "[" << reg.instr.text << "]\n";
-        std::cout << "    PC=" << reg.pc << "\n";
-        printControlSignals(reg.ctrl);
-        std::cout << "    " << regName(reg.instr.rs) << "=" << reg.rsVal
-                  << ", " << regName(reg.instr.rt) << "=" << reg.rtVal
-                  << ", SignExtImm=" << reg.signExtImm
-                  << ", DestReg=" << regName(reg.destReg) << "\n";
+        out << "[" << sourceText(source, reg.pc) << "]\n";
+        out << "    PC=" << reg.pc << "\n";
+        printControlSignals(reg.ctrl, out);
+        out << "    " << regName(reg.instr.rs) << "=" << reg.rsVal
+            << ", " << regName(reg.instr.rt) << "=" << reg.rtVal
+            << ", SignExtImm=" << reg.signExtImm
+            << ", DestReg=" << regName(reg.destReg) << "\n";
     } else {
-        std::cout << "[empty]\n";
+        out << "[empty]\n";
     }
 }
 
-void Debug::printEX_MEM(const EX_MEM& reg) {
-    std::cout << "  EX/MEM: ";
+void Debug::printEX_MEM(const EX_MEM& reg, const std::vector<SourceLine>& source, std::ostream& out) {
+    out << "  EX/MEM: ";
     if (reg.valid) {
-        std::cout << "[" << reg.instr.text << "]\n";
-        std::cout << "    PC=" << reg.pc << "\n";
-        printControlSignals(reg.ctrl);
-        std::cout << "    ALUResult=" << reg.aluResult
-                  << ", DestReg=" << regName(reg.destReg);
+        out << "[" << sourceText(source, reg.pc) << "]\n";
+        out << "    PC=" << reg.pc << "\n";
+        printControlSignals(reg.ctrl, out);
+        out << "    ALUResult=" << reg.aluResult
+            << ", DestReg=" << regName(reg.destReg);
         if (reg.branchTaken) {
-            std::cout << ", BRANCH TAKEN to " << reg.branchTarget;
+            out << ", BRANCH TAKEN to " << reg.branchTarget;
         }
-        std::cout << "\n";
+        out << "\n";
     } else {
-        std::cout << "[empty]\n";
+        out << "[empty]\n";
     }
 }
 
-void Debug::printMEM_WB(const MEM_WB& reg) {
-    std::cout << "  MEM/WB: ";
+void Debug::printMEM_WB(const MEM_WB& reg, const std::vector<SourceLine>& source, std::ostream& out) {
+    out << "  MEM/WB: ";
     if (reg.valid) {
-        std::cout << "[" << reg.instr.text << "]\n";
-        std::cout << "    PC=" << reg.pc << "\n";
-        printControlSignals(reg.ctrl);
-        std::cout << "    ALUResult=" << reg.aluResult;
+        out << "[" << sourceText(source, reg.pc) << "]\n";
+        out << "    PC=" << reg.pc << "\n";
+        printControlSignals(reg.ctrl, out);
+        out << "    ALUResult=" << reg.aluResult;
         if (reg.ctrl.memToReg) {
-            std::cout << ", MemData=" << reg.memReadData;
+            out << ", MemData=" << reg.memReadData;
         }
-        std::cout << ", DestReg=" << regName(reg.destReg) << "\n";
+        out << ", DestReg=" << regName(reg.destReg) << "\n";
     } else {
-        std::cout << "[empty]\n";
+        out << "[empty]\n";
     }
 }
 
-void Debug::printPipelineState(const CPU& cpu) {
-    std::cout << "\n========== CYCLE " << cpu.getCycleCount() << " ==========\n";
-    std::cout << "PC = " << cpu.getPC() << "\n\n";
+void Debug::printStallStats(const CPU& cpu) {
+    const PipelineConfig& config = cpu.getConfig();
+    const StallStats& stalls = cpu.getStallStats();
     
-    std::cout << "--- Pipeline Registers ---\n";
-    printIF_ID(cpu.getIF_ID());
-    printID_EX(cpu.getID_EX());
-    printEX_MEM(cpu.getEX_MEM());
-    printMEM_WB(cpu.getMEM_WB());
+    std::cout << "Forwarding: " << (config.forwarding ? "on" : "off")
+              << ", Hazard detection: " << (config.hazardDetection ? "on" : "off") << "\n";
+    std::cout << "Instructions Retired: " << cpu.getInstructionCount() << "\n";
+    if (cpu.getInstructionCount() > 0) {
+        std::cout << "CPI: " << std::fixed << std::setprecision(3)
+                  << static_cast<double>(cpu.getCycleCount()) / cpu.getInstructionCount()
+                  << std::defaultfloat << "\n";
+    }
+    std::cout << "Stalls (load-use): " << stalls.loadUse << "\n";
+    std::cout << "Stalls (data hazard): " << stalls.dataHazard << "\n";
+    std::cout << "Branch flushes: " << stalls.flushes << "\n";
+    std::cout << "Stalls (I-cache): " << stalls.icacheMiss << "\n";
+    std::cout << "Stalls (D-cache): " << stalls.dcacheMiss << "\n";
+}
+
+void Debug::printBranchStats(const CPU& cpu) {
+    const std::vector<BranchStats>& stats = cpu.getBranchStats();
+    size_t executed = 0, mispredicted = 0;
+    for (const BranchStats& b : stats) {
+        executed += b.executed;
+        mispredicted += b.mispredicted;
+    }
+    
+    std::cout << "\n--- Branch Prediction (" << cpu.getPredictor()->name() << ") ---\n";
+    std::cout << "Branches: " << executed << ", Mispredicted: " << mispredicted;
+    if (executed > 0) {
+        std::cout << ", Accuracy: " << std::fixed << std::setprecision(1)
+                  << 100.0 * (executed - mispredicted) / executed << "%" << std::defaultfloat;
+    }
+    std::cout << "\n";
+    
+    for (size_t pc = 0; pc < stats.size(); pc++) {
+        const BranchStats& b = stats[pc];
+        if (b.executed == 0) continue;
+        std::cout << "  [" << std::setw(4) << (pc * 4) << "] exec=" << std::setw(6) << b.executed
+                  << " taken=" << std::setw(6) << b.taken
+                  << " mispred=" << std::setw(6) << b.mispredicted
+                  << "  " << sourceText(cpu.getSource(), pc) << "\n";
+    }
+}
+
+static void printOneCache(const char* name, const Cache* cache, size_t stallCycles) {
+    if (!cache) return;
+    const CacheStats& st = cache->getStats();
+    size_t accesses = st.hits + st.misses;
     
-    printRegisters(cpu.getRegisters());
-    std::cout << "================================\n";
+    std::cout << name << " (" << cacheConfigToString(cache->getConfig()) << ")\n";
+    std::cout << "  Reads: " << st.reads << ", Writes: " << st.writes
+              << ", Hits: " << st.hits << ", Misses: " << st.misses;
+    if (accesses > 0) {
+        std::cout << ", Hit rate: " << std::fixed << std::setprecision(1)
+                  << 100.0 * st.hits / accesses << "%" << std::defaultfloat;
+    }
+    std::cout << "\n  Writebacks: " << st.writebacks
+              << ", Stall cycles: " << stallCycles << "\n";
+}
+
+void Debug::printCacheStats(const CPU& cpu) {
+    std::cout << "\n--- Caches ---\n";
+    printOneCache("I-cache", cpu.getICache(), cpu.getStallStats().icacheMiss);
+    printOneCache("D-cache", cpu.getDCache(), cpu.getStallStats().dcacheMiss);
+}
+
+void Debug::capture(const CPU& cpu, size_t fetchPc, DebugSnapshot& snapshot) {
+    snapshot.mode = cpu.getMode();
+    snapshot.cycle = cpu.getCycleCount();
+    snapshot.pc = cpu.getPC();
+    snapshot.fetchPc = fetchPc;
+    snapshot.if_id = cpu.getIF_ID();
+    snapshot.id_ex = cpu.getID_EX();
+    snapshot.ex_mem = cpu.getEX_MEM();
+    snapshot.mem_wb = cpu.getMEM_WB();
+    snapshot.registers = cpu.getRegisters();
+}
+
+void Debug::printState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                       std::ostream& out) {
+    if (snapshot.mode != ExecMode::PIPELINE) {
+        printFunctionalState(snapshot, source, out);
+    } else {
+        printPipelineState(snapshot, source, out);
+    }
 }
 
-void Debug::printBinaryRepresentation(const std::vector<Instruction>& instructions) {
+void Debug::printPipelineState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                               std::ostream& out) {
+    out << "\n========== CYCLE " << snapshot.cycle << " ==========\n";
+    out << "PC = " << snapshot.pc << "\n\n";
+    
+    out << "--- Pipeline Registers ---\n";
+    printIF_ID(snapshot.if_id, source, out);
+    printID_EX(snapshot.id_ex, source, out);
+    printEX_MEM(snapshot.ex_mem, source, out);
+    printMEM_WB(snapshot.mem_wb, source, out);
+    
+    printRegisters(snapshot.registers, out);
+    out << "================================\n";
+}
+
+void Debug::printFunctionalState(const DebugSnapshot& snapshot, const std::vector<SourceLine>& source,
+                                 std::ostream& out) {
+    out << "\n========== STEP " << snapshot.cycle << " ==========\n";
+    out << "PC = " << snapshot.fetchPc << "  [" << sourceText(source, snapshot.fetchPc) << "]\n";
+    out << "Next PC = " << snapshot.pc << "\n";
+    
+    printRegisters(snapshot.registers, out);
+    out << "================================\n";
+}
+
+bool Debug::compareState(const CPU& expected, const CPU& actual) {
+    bool match = true;
+    const auto& expRegs = expected.getRegisters();
+    const auto& actRegs = actual.getRegisters();
+    
+    for (int i = 0; i < 32; i++) {
+        if (expRegs[i] != actRegs[i]) {
+            std::cout << "  " << regName(i) << ": " << execModeToString(expected.getMode())
+                      << "=" << expRegs[i] << ", " << execModeToString(actual.getMode())
+                      << "=" << actRegs[i] << "\n";
+            match = false;
+        }
+    }
+    
+    const GuestMemory& expMem = expected.getMemory();
+    const GuestMemory& actMem = actual.getMemory();
+    
+    // Compare every page either side has touched
+    std::vector<uint32_t> pageNumbers = expMem.touchedPages();
+    std::vector<uint32_t> actPages = actMem.touchedPages();
+    pageNumbers.insert(pageNumbers.end(), actPages.begin(), actPages.end());
+    std::sort(pageNumbers.begin(), pageNumbers.end());
+    pageNumbers.erase(std::unique(pageNumbers.begin(), pageNumbers.end()), pageNumbers.end());
+    
+    for (uint32_t number : pageNumbers) {
+        uint32_t base = number << GuestMemory::PAGE_BITS;
+        for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS; i++) {
+            uint32_t address = base + i * 4;
+            int32_t e = expMem.load(address);
+            int32_t a = actMem.load(address);
+            if (e != a) {
+                std::cout << "  [" << std::setw(4) << address << "]: "
+                          << execModeToString(expected.getMode()) << "=" << e << ", "
+                          << execModeToString(actual.getMode()) << "=" << a << "\n";
+                match = false;
+            }
+        }
+    }
+    
+    return match;
+}
+
+void Debug::printBinaryRepresentation(const std::vector<Instruction>& instructions,
+                                      const std::vector<SourceLine>& source) {
     std::cout << "\n--- Binary Representation ---" << std::endl;
     std::cout << std::setw(4) << "Addr" << "  " << std::setw(32) << "Binary" 
               << "  " << "Assembly" << std::endl;
     std::cout << std::string(60, '-') << std::endl;
     
     for (size_t i = 0; i < instructions.size(); i++) {
-        const Instruction& instr = instructions[i];
-        uint32_t binary = 0;
-        
-        switch (instr.op) {
-            case Opcode::ADD:
-                binary = (0 << 26) | (instr.rs << 21) | (instr.rt << 16) 
-                       | (instr.rd << 11) | (0 << 6) | 0x20;
-                break;
-            case Opcode::SUB:
-                binary = (0 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (0 << 6) | 0x22;
-                break;
-            case Opcode::MUL:
-                binary = (0x1C << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (0 << 6) | 0x02;
-                break;
-            case Opcode::AND:
-                binary = (0 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (0 << 6) | 0x24;
-                break;
-            case Opcode::OR:
-                binary = (0 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (0 << 6) | 0x25;
-                break;
-            case Opcode::SLL:
-                binary = (0 << 26) | (0 << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (instr.shamt << 6) | 0x00;
-                break;
-            case Opcode::SRL:
-                binary = (0 << 26) | (0 << 21) | (instr.rt << 16)
-                       | (instr.rd << 11) | (instr.shamt << 6) | 0x02;
-                break;
-            case Opcode::ADDI:
-                binary = (0x08 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.imm & 0xFFFF);
-                break;
-            case Opcode::LW:
-                binary = (0x23 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.imm & 0xFFFF);
-                break;
-            case Opcode::SW:
-                binary = (0x2B << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (instr.imm & 0xFFFF);
-                break;
-            case Opcode::BEQ:
-                binary = (0x04 << 26) | (instr.rs << 21) | (instr.rt << 16)
-                       | (static_cast<int32_t>(instr.target - i - 1) & 0xFFFF);
-                break;
-            case Opcode::J:
-                binary = (0x02 << 26) | (instr.target & 0x03FFFFFF);
-                break;
-            case Opcode::NOP:
-                binary = 0;
-                break;
-            default:
-                binary = 0xFFFFFFFF;
-        }
+        uint32_t binary = MachineCode::encode(instructions[i], i);
         
         std::cout << std::setw(4) << (i * 4) << "  "
                   << std::bitset<32>(binary) << "  "
-                  << instr.text << "\n";
+                  << sourceText(source, i) << "\n";
     }
     std::cout << std::endl;
 }
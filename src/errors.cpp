@@ -1,6 +1,7 @@
 #include "../include/errors.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -16,6 +17,11 @@ size_t ErrorHandler::errorCount() const {
     return errors.size();
 }
 
+void ErrorHandler::sortByLine() {
+    stable_sort(errors.begin(), errors.end(),
+                [](const Error& a, const Error& b) { return a.line < b.line; });
+}
+
 void ErrorHandler::printErrors() const {
     cerr << "\n=== ASSEMBLY ERRORS ===" << endl;   // safe use of endl
 
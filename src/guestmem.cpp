@@ -0,0 +1,323 @@
+#include "../include/guestmem.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#if defined(__linux__)
+#define GUESTMEM_FLAT 1
+#include <signal.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+#endif
+
+using namespace std;
+
+static const uint64_t FLAT_RESERVATION = 1ULL << 32;
+
+// FaultScope bookkeeping (per simulation thread)
+static thread_local sigjmp_buf* faultEnv = nullptr;
+static thread_local uint32_t faultAddress = 0;
+
+GuestMemory::FaultScope::FaultScope() {
+    faultEnv = &env;
+}
+
+GuestMemory::FaultScope::~FaultScope() {
+    faultEnv = nullptr;
+}
+
+uint32_t GuestMemory::lastFaultAddress() {
+    return faultAddress;
+}
+
+#ifdef GUESTMEM_FLAT
+
+// Every live FLAT memory is registered here so the SIGSEGV handler can tell
+// guest page faults apart from real crashes
+static const size_t MAX_FLAT_REGIONS = 256;
+static atomic<GuestMemory*> flatRegions[MAX_FLAT_REGIONS];
+static struct sigaction previousAction;
+static once_flag handlerOnce;
+
+// Whether the faulting access was a store. Where the kernel's error code is
+// not available every first touch counts as a read; a store then faults a
+// second time on the read-only page and is recorded there.
+static bool isWriteFault(void* context) {
+#if defined(__x86_64__) && defined(REG_ERR)
+    return (static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_ERR] & 2) != 0;
+#else
+    (void)context;
+    return false;
+#endif
+}
+
+struct FlatFaultHandler {
+    // Reads commit the page read-only and clean, like a load from an
+    // untouched page in the PAGED backend; only a write makes it dirty
+    static bool commit(GuestMemory* mem, uint32_t number, bool write) {
+        void* page = mem->flatBase + (static_cast<uint64_t>(number) << GuestMemory::PAGE_BITS);
+        if (mprotect(page, GuestMemory::PAGE_SIZE, write ? PROT_READ | PROT_WRITE : PROT_READ) != 0) {
+            return false;
+        }
+        mem->committed[number >> 6] |= 1ULL << (number & 63);
+        if (write) {
+            mem->dirtyBits[number >> 6] |= 1ULL << (number & 63);
+        }
+        return true;
+    }
+    
+    static bool isCommitted(const GuestMemory* mem, uint32_t number) {
+        return (mem->committed[number >> 6] & (1ULL << (number & 63))) != 0;
+    }
+    
+    static void handle(int sig, siginfo_t* info, void* context) {
+        uint8_t* addr = static_cast<uint8_t*>(info->si_addr);
+        
+        for (size_t i = 0; i < MAX_FLAT_REGIONS; i++) {
+            GuestMemory* mem = flatRegions[i].load(memory_order_acquire);
+            if (!mem || addr < mem->flatBase || addr >= mem->flatBase + FLAT_RESERVATION) {
+                continue;
+            }
+            
+            // First touch commits the page. A committed page only faults when
+            // it is read-only (first touched by a read, or reset by
+            // clearDirty()), so that fault is a write: make it writable and
+            // mark it dirty
+            uint32_t offset = static_cast<uint32_t>(addr - mem->flatBase);
+            uint32_t number = offset >> GuestMemory::PAGE_BITS;
+            if (commit(mem, number, isCommitted(mem, number) || isWriteFault(context))) {
+                return;
+            }
+            
+            if (faultEnv) {
+                faultAddress = offset;
+                siglongjmp(*faultEnv, 1);
+            }
+            break;
+        }
+        
+        // Not a guest page: hand over to whatever was installed before
+        if (previousAction.sa_flags & SA_SIGINFO) {
+            if (previousAction.sa_sigaction) {
+                previousAction.sa_sigaction(sig, info, context);
+                return;
+            }
+        } else if (previousAction.sa_handler != SIG_DFL && previousAction.sa_handler != SIG_IGN) {
+            previousAction.sa_handler(sig);
+            return;
+        }
+        signal(sig, SIG_DFL);
+    }
+};
+
+static void installFaultHandler() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = FlatFaultHandler::handle;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &previousAction);
+}
+
+#endif // GUESTMEM_FLAT
+
+GuestMemory::GuestMemory(MemoryBackend backend)
+    : backend(MemoryBackend::PAGED)
+    , lastNumber(0xFFFFFFFFu)
+    , lastPage(nullptr)
+    , flatBase(nullptr)
+{
+    if (backend == MemoryBackend::FLAT && initFlat()) {
+        this->backend = MemoryBackend::FLAT;
+    }
+}
+
+bool GuestMemory::initFlat() {
+#ifdef GUESTMEM_FLAT
+    void* region = mmap(nullptr, FLAT_RESERVATION, PROT_NONE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED) return false;
+    
+    for (size_t i = 0; i < MAX_FLAT_REGIONS; i++) {
+        GuestMemory* expected = nullptr;
+        if (flatRegions[i].compare_exchange_strong(expected, this)) {
+            call_once(handlerOnce, installFaultHandler);
+            flatBase = static_cast<uint8_t*>(region);
+            committed.assign(PAGE_COUNT / 64, 0);
+            dirtyBits.assign(PAGE_COUNT / 64, 0);
+            return true;
+        }
+    }
+    
+    munmap(region, FLAT_RESERVATION);
+#endif
+    return false;
+}
+
+GuestMemory::~GuestMemory() {
+#ifdef GUESTMEM_FLAT
+    if (flatBase) {
+        for (size_t i = 0; i < MAX_FLAT_REGIONS; i++) {
+            GuestMemory* expected = this;
+            if (flatRegions[i].compare_exchange_strong(expected, nullptr)) break;
+        }
+        munmap(flatBase, FLAT_RESERVATION);
+    }
+#endif
+}
+
+GuestMemory::Page* GuestMemory::findPage(uint32_t number) const {
+    const unique_ptr<PageTable>& table = directory[number >> TABLE_BITS];
+    if (!table) return nullptr;
+    
+    Page* page = (*table)[number & ((1u << TABLE_BITS) - 1)];
+    if (page) {
+        lastNumber = number;
+        lastPage = page;
+    }
+    return page;
+}
+
+GuestMemory::Page* GuestMemory::allocatePage(uint32_t number) {
+    Page* page = findPage(number);
+    if (page) return page;
+    
+    unique_ptr<PageTable>& table = directory[number >> TABLE_BITS];
+    if (!table) {
+        table.reset(new PageTable());
+        table->fill(nullptr);
+    }
+    
+    pages.emplace_back(new Page(number));
+    page = pages.back().get();
+    (*table)[number & ((1u << TABLE_BITS) - 1)] = page;
+    
+    lastNumber = number;
+    lastPage = page;
+    return page;
+}
+
+vector<uint32_t> GuestMemory::touchedPages() const {
+    vector<uint32_t> result;
+    
+    if (flatBase) {
+        for (size_t w = 0; w < committed.size(); w++) {
+            uint64_t bits = committed[w];
+            while (bits) {
+                unsigned bit = __builtin_ctzll(bits);
+                result.push_back(static_cast<uint32_t>(w * 64 + bit));
+                bits &= bits - 1;
+            }
+        }
+        return result;
+    }
+    
+    result.reserve(pages.size());
+    for (const auto& page : pages) {
+        result.push_back(page->number);
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+const int32_t* GuestMemory::pageData(uint32_t number) const {
+    if (flatBase) {
+        if (!(committed[number >> 6] & (1ULL << (number & 63)))) return nullptr;
+        return reinterpret_cast<const int32_t*>(
+            flatBase + (static_cast<uint64_t>(number) << PAGE_BITS));
+    }
+    const Page* page = findPage(number);
+    return page ? page->words.data() : nullptr;
+}
+
+bool GuestMemory::isPageDirty(uint32_t number) const {
+    if (flatBase) {
+        return (dirtyBits[number >> 6] & (1ULL << (number & 63))) != 0;
+    }
+    const Page* page = findPage(number);
+    return page && page->dirty;
+}
+
+void GuestMemory::writePage(uint32_t number, const int32_t* words) {
+#ifdef GUESTMEM_FLAT
+    if (flatBase) {
+        FlatFaultHandler::commit(this, number, true);
+        memcpy(flatBase + (static_cast<uint64_t>(number) << PAGE_BITS), words, PAGE_SIZE);
+        return;
+    }
+#endif
+    Page* page = allocatePage(number);
+    memcpy(page->words.data(), words, sizeof(page->words));
+    page->dirty = true;
+}
+
+bool GuestMemory::mapPages(uint32_t first, uint32_t count, int fd, uint64_t offset) {
+#ifdef GUESTMEM_FLAT
+    if (flatBase && count > 0) {
+        void* target = flatBase + (static_cast<uint64_t>(first) << PAGE_BITS);
+        void* mapped = mmap(target, static_cast<size_t>(count) << PAGE_BITS,
+                            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                            static_cast<off_t>(offset));
+        if (mapped == MAP_FAILED) return false;
+        
+        for (uint32_t number = first; number < first + count; number++) {
+            committed[number >> 6] |= 1ULL << (number & 63);
+            dirtyBits[number >> 6] |= 1ULL << (number & 63);
+        }
+        return true;
+    }
+#endif
+    (void)first;
+    (void)count;
+    (void)fd;
+    (void)offset;
+    return false;
+}
+
+size_t GuestMemory::pageCount() const {
+    if (flatBase) {
+        size_t count = 0;
+        for (uint64_t bits : committed) count += __builtin_popcountll(bits);
+        return count;
+    }
+    return pages.size();
+}
+
+size_t GuestMemory::dirtyPageCount() const {
+    size_t count = 0;
+    if (flatBase) {
+        for (uint64_t bits : dirtyBits) count += __builtin_popcountll(bits);
+        return count;
+    }
+    for (const auto& page : pages) {
+        if (page->dirty) count++;
+    }
+    return count;
+}
+
+void GuestMemory::clearDirty() {
+#ifdef GUESTMEM_FLAT
+    if (flatBase) {
+        // Write-protect committed pages so the next store to each one faults
+        // and is recorded as dirty again
+        for (uint32_t number : touchedPages()) {
+            mprotect(flatBase + (static_cast<uint64_t>(number) << PAGE_BITS), PAGE_SIZE, PROT_READ);
+        }
+        fill(dirtyBits.begin(), dirtyBits.end(), 0);
+        return;
+    }
+#endif
+    for (auto& page : pages) {
+        page->dirty = false;
+    }
+}
+
+string memoryBackendToString(MemoryBackend backend) {
+    switch (backend) {
+        case MemoryBackend::PAGED: return "paged";
+        case MemoryBackend::FLAT:  return "flat";
+        default:                   return "unknown";
+    }
+}
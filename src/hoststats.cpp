@@ -0,0 +1,110 @@
+#include "../include/hoststats.h"
+#include <cstdio>
+#include <iomanip>
+
+using namespace std;
+
+static double elapsedSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+HostStats::HostStats()
+    : wallSeconds(0), tickStart(0), ticks(0), startCycles(0), startInstructions(0),
+      cycles(0), instructions(0), sampleMask(SIZE_MAX), samples(0), stageTicks(), lastMark(0),
+      debugSamples(0), debugTicks(0), formatTicks(0), progressInterval(0), nextProgress(0),
+      progressShown(false) {}
+
+void HostStats::setSamplePeriod(size_t period) {
+    if (period == 0) {
+        sampleMask = SIZE_MAX;
+        return;
+    }
+    size_t size = 1;
+    while (size < period) size <<= 1;
+    sampleMask = size - 1;
+}
+
+void HostStats::begin(size_t cycleCount, size_t instructionCount) {
+    startCycles = cycleCount;
+    startInstructions = instructionCount;
+    cycles = 0;
+    instructions = 0;
+    nextProgress = progressInterval;
+    wallStart = chrono::steady_clock::now();
+    tickStart = now();
+}
+
+void HostStats::end(size_t cycleCount, size_t instructionCount) {
+    ticks = now() - tickStart;
+    wallSeconds = elapsedSince(wallStart);
+    cycles = cycleCount - startCycles;
+    instructions = instructionCount - startInstructions;
+    if (progressShown) {
+        fputc('\n', stderr);
+        progressShown = false;
+    }
+}
+
+double HostStats::cyclesPerSecond() const {
+    return wallSeconds > 0 ? cycles / wallSeconds : 0.0;
+}
+
+double HostStats::instructionsPerSecond() const {
+    return wallSeconds > 0 ? instructions / wallSeconds : 0.0;
+}
+
+// Written with stdio on one line, rewritten in place with \r
+void HostStats::progress(size_t cycleCount, size_t instructionCount) {
+    double elapsed = elapsedSince(wallStart);
+    if (elapsed < nextProgress) return;
+    nextProgress = elapsed + progressInterval;
+
+    double cycleRate = (cycleCount - startCycles) / elapsed;
+    double instrRate = (instructionCount - startInstructions) / elapsed;
+    fprintf(stderr, "\r[%8.1fs] cycle %zu, %.2f M cycles/s, %.2f MIPS   ", elapsed, cycleCount,
+            cycleRate / 1e6, instrRate / 1e6);
+    fflush(stderr);
+    progressShown = true;
+}
+
+void HostStats::report(ostream& out) const {
+    ios::fmtflags flags = out.flags();
+    out << fixed;
+
+    out << "\n=== HOST PERFORMANCE ===" << endl;
+    out << "Wall time:     " << setprecision(6) << wallSeconds << " s" << endl;
+    out << "Cycles:        " << cycles << " (" << setprecision(3) << cyclesPerSecond() / 1e6
+        << " M cycles/s)" << endl;
+    out << "Instructions:  " << instructions << " (" << setprecision(3)
+        << instructionsPerSecond() / 1e6 << " MIPS)" << endl;
+
+    // Host ticks per nanosecond, calibrated against the wall clock over the run
+    double ticksPerNs = wallSeconds > 0 ? ticks / (wallSeconds * 1e9) : 0.0;
+    auto nanos = [ticksPerNs](double t) { return ticksPerNs > 0 ? t / ticksPerNs : 0.0; };
+
+    if (samples > 0) {
+        uint64_t total = 0;
+        for (int stage = 0; stage < HOST_STAGES; stage++) total += stageTicks[stage];
+        static const char* names[HOST_STAGES] = {"WB", "MEM", "EX", "ID", "IF", "resolve"};
+
+        out << "\n--- Stage Cost (1 in " << getSamplePeriod() << " cycles, " << samples
+            << " samples) ---" << endl;
+        for (int stage = 0; stage < HOST_STAGES; stage++) {
+            out << "  " << left << setw(8) << names[stage] << right << setw(9) << setprecision(1)
+                << nanos(double(stageTicks[stage]) / samples) << " ns/cycle" << setw(8)
+                << setprecision(1) << (total ? 100.0 * stageTicks[stage] / total : 0.0) << "%" << endl;
+        }
+        out << "  " << left << setw(8) << "total" << right << setw(9) << setprecision(1)
+            << nanos(double(total) / samples) << " ns/cycle" << endl;
+    }
+    if (debugSamples > 0) {
+        out << "Debug snapshot: " << setprecision(1) << nanos(double(debugTicks) / debugSamples)
+            << " ns/cycle (simulation thread)" << endl;
+    }
+    if (formatTicks > 0) {
+        out << "Debug printing: " << setprecision(6) << nanos(double(formatTicks)) / 1e9
+            << " s (writer thread)" << endl;
+    }
+
+    out.flags(flags);
+}
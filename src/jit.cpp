@@ -0,0 +1,415 @@
+#include "../include/jit.h"
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// The region starts with a shared entry trampoline and epilogue. run() calls
+// the trampoline with the System V convention:
+//   rdi = guest registers (pinned std::array<int32_t, 32>), kept in rbx
+//   rsi = GuestMemory*, kept in r12
+//   rdx = int64_t* instruction budget, copied to [rsp] and stored back on exit
+//   rcx = entry of the first block, jumped to
+// It pushes every callee-saved register and sets r13 to the flat base (FLAT
+// memory only). Blocks are jumped to, never called, so rsp stays 16-byte
+// aligned for the LW/SW helper calls.
+//
+// Inside a block, guest registers used more than once live in host registers
+// (see allocate). They are loaded from the array on entry if the block reads
+// them first, and written back only when the block exits. Other guest
+// registers stay in the array; eax/ecx/edx are scratch. With paged memory,
+// LW/SW call back into GuestMemory through small helpers, so only
+// callee-saved registers hold guest values. With a FLAT memory they are a
+// single host access, [r13 + address]. Pages are committed by the SIGSEGV
+// handler in guestmem.cpp, which resumes the faulting instruction.
+//
+// Every exit sets eax to the next pc and charges the block to the budget.
+// While budget remains it jumps through entries[next pc], straight to the
+// next block when that one is compiled; otherwise, or once the budget is
+// used up, it leaves through the epilogue, which returns the next pc.
+
+namespace {
+
+enum HostReg {
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R8 = 8, R9 = 9, R10 = 10, R11 = 11, R12 = 12, R13 = 13, R14 = 14, R15 = 15
+};
+
+// Host registers for guest values. Paged blocks call out, so they keep to
+// callee-saved registers; r12 holds the GuestMemory* there and r13 the flat
+// base in FLAT blocks.
+const int PAGED_POOL[] = {RBP, R13, R14, R15};
+const int FLAT_POOL[] = {RBP, R12, R14, R15, RSI, RDI, R8, R9, R10, R11};
+
+const int NO_REG = -1;
+
+int32_t jitLoad(GuestMemory* memory, uint32_t address) {
+    return memory->load(address);
+}
+
+void jitStore(GuestMemory* memory, uint32_t address, int32_t value) {
+    memory->store(address, value);
+}
+
+void emit8(vector<uint8_t>& buf, uint8_t b) {
+    buf.push_back(b);
+}
+
+void emit32(vector<uint8_t>& buf, uint32_t v) {
+    for (int i = 0; i < 4; i++) buf.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+void emit64(vector<uint8_t>& buf, uint64_t v) {
+    for (int i = 0; i < 8; i++) buf.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+void emitBytes(vector<uint8_t>& buf, std::initializer_list<uint8_t> bytes) {
+    buf.insert(buf.end(), bytes.begin(), bytes.end());
+}
+
+// Guest register -> host register for one block, NO_REG if kept in memory
+typedef int Allocation[32];
+
+// <op> reg, rm  (32-bit, both host registers)
+void emitRR(vector<uint8_t>& buf, std::initializer_list<uint8_t> opcode, int reg, int rm) {
+    if (reg >= 8 || rm >= 8) {
+        emit8(buf, static_cast<uint8_t>(0x40 | (reg >= 8 ? 0x04 : 0) | (rm >= 8 ? 0x01 : 0)));
+    }
+    emitBytes(buf, opcode);
+    emit8(buf, static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// <op> reg, [rbx + guest*4]  (32-bit)
+void emitRM(vector<uint8_t>& buf, std::initializer_list<uint8_t> opcode, int reg, int guest) {
+    if (reg >= 8) emit8(buf, 0x44);
+    emitBytes(buf, opcode);
+    emit8(buf, static_cast<uint8_t>(0x43 | ((reg & 7) << 3)));
+    emit8(buf, static_cast<uint8_t>(guest * 4));
+}
+
+// <op> reg, guest, wherever the guest register lives
+// (op = 8B mov, 03 add, 2B sub, 23 and, 0B or, 3B cmp, 0F AF imul)
+// $zero is never allocated, and its array slot always reads 0
+void emitGuestOp(vector<uint8_t>& buf, std::initializer_list<uint8_t> opcode, int reg,
+                 const Allocation& alloc, int guest) {
+    if (alloc[guest] != NO_REG) {
+        emitRR(buf, opcode, reg, alloc[guest]);
+    } else {
+        emitRM(buf, opcode, reg, guest);
+    }
+}
+
+void loadReg(vector<uint8_t>& buf, const Allocation& alloc, int guest) {
+    emitGuestOp(buf, {0x8B}, RAX, alloc, guest);
+}
+
+// guest = eax (writes to $zero are dropped)
+void storeReg(vector<uint8_t>& buf, const Allocation& alloc, int guest) {
+    if (guest == 0) return;
+    if (alloc[guest] != NO_REG) {
+        emitRR(buf, {0x8B}, alloc[guest], RAX);
+    } else {
+        emitRM(buf, {0x89}, RAX, guest);
+    }
+}
+
+// eax = rs + offset (guest byte address)
+void emitAddress(vector<uint8_t>& buf, const Allocation& alloc, int base, int32_t offset) {
+    loadReg(buf, alloc, base);
+    emit8(buf, 0x05);                      // add eax, imm32
+    emit32(buf, static_cast<uint32_t>(offset));
+}
+
+// mov rax, fn; call rax
+void emitCall(vector<uint8_t>& buf, const void* fn) {
+    emitBytes(buf, {0x48, 0xB8});
+    emit64(buf, reinterpret_cast<uint64_t>(fn));
+    emitBytes(buf, {0xFF, 0xD0});
+}
+
+// Give host registers to the guest registers the block uses most, as long
+// as they are used more than once (a single use is as cheap from memory)
+void allocate(const BasicBlock& block, const vector<MicroOp>& microOps, bool flat,
+              Allocation& alloc) {
+    int uses[32] = {0};
+    for (size_t pc = block.start; pc < block.start + block.length; pc++) {
+        const MicroOp& u = microOps[pc];
+        if (u.op == Opcode::NOP || u.op == Opcode::J) continue;
+        uses[u.rs]++;
+        if (u.op != Opcode::ADDI && u.op != Opcode::LW) uses[u.rt]++;
+        if (u.op != Opcode::SW && u.op != Opcode::BEQ) uses[u.dest]++;
+    }
+    uses[0] = 0;
+    
+    const int* pool = flat ? FLAT_POOL : PAGED_POOL;
+    const size_t poolSize = flat ? sizeof(FLAT_POOL) / sizeof(int)
+                                 : sizeof(PAGED_POOL) / sizeof(int);
+    for (int guest = 0; guest < 32; guest++) alloc[guest] = NO_REG;
+    for (size_t i = 0; i < poolSize; i++) {
+        int best = 0;
+        for (int guest = 1; guest < 32; guest++) {
+            if (alloc[guest] == NO_REG && uses[guest] > uses[best]) best = guest;
+        }
+        if (uses[best] < 2) break;
+        alloc[best] = pool[i];
+        uses[best] = 0;
+    }
+}
+
+} // namespace
+
+bool JitCompiler::available() {
+#ifdef JIT_X86_64
+    return true;
+#else
+    return false;
+#endif
+}
+
+JitCompiler::JitCompiler(size_t programSize, uint8_t* flatBase, size_t capacityBytes)
+    : code(nullptr)
+    , capacity(0)
+    , used(0)
+    , flatBase(flatBase)
+    , epilogue(nullptr)
+{
+#ifdef JIT_X86_64
+    void* region = mmap(nullptr, capacityBytes, PROT_READ | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) return;
+    code = static_cast<uint8_t*>(region);
+    capacity = capacityBytes;
+    
+    vector<uint8_t> buf;
+    emitBytes(buf, {0x53, 0x55});                      // push rbx; push rbp
+    emitBytes(buf, {0x41, 0x54, 0x41, 0x55});          // push r12; push r13
+    emitBytes(buf, {0x41, 0x56, 0x41, 0x57});          // push r14; push r15
+    emitBytes(buf, {0x48, 0x83, 0xEC, 0x18});          // sub rsp, 24
+    emitBytes(buf, {0x48, 0x89, 0x54, 0x24, 0x08});    // mov [rsp + 8], rdx
+    emitBytes(buf, {0x48, 0x8B, 0x02});                // mov rax, [rdx]
+    emitBytes(buf, {0x48, 0x89, 0x04, 0x24});          // mov [rsp], rax
+    emitBytes(buf, {0x48, 0x89, 0xFB});                // mov rbx, rdi
+    emitBytes(buf, {0x49, 0x89, 0xF4});                // mov r12, rsi
+    if (flatBase) {
+        emitBytes(buf, {0x49, 0xBD});                  // mov r13, imm64
+        emit64(buf, reinterpret_cast<uint64_t>(flatBase));
+    }
+    emitBytes(buf, {0xFF, 0xE1});                      // jmp rcx
+    const size_t epilogueOffset = buf.size();
+    emitBytes(buf, {0x48, 0x8B, 0x4C, 0x24, 0x08});    // mov rcx, [rsp + 8]
+    emitBytes(buf, {0x48, 0x8B, 0x14, 0x24});          // mov rdx, [rsp]
+    emitBytes(buf, {0x48, 0x89, 0x11});                // mov [rcx], rdx
+    emitBytes(buf, {0x48, 0x83, 0xC4, 0x18});          // add rsp, 24
+    emitBytes(buf, {0x41, 0x5F, 0x41, 0x5E});          // pop r15; pop r14
+    emitBytes(buf, {0x41, 0x5D, 0x41, 0x5C});          // pop r13; pop r12
+    emitBytes(buf, {0x5D, 0x5B, 0xC3});                // pop rbp; pop rbx; ret
+    
+    if (!install(buf)) {
+        munmap(code, capacity);
+        code = nullptr;
+        capacity = 0;
+        return;
+    }
+    epilogue = code + epilogueOffset;
+    entries.assign(programSize + 1, epilogue);
+#else
+    (void)programSize;
+    (void)capacityBytes;
+#endif
+}
+
+JitCompiler::~JitCompiler() {
+#ifdef JIT_X86_64
+    if (code) munmap(code, capacity);
+#endif
+}
+
+void JitCompiler::emitBlock(
+    const BasicBlock& block,
+    const vector<MicroOp>& microOps,
+    const uint8_t* base,
+    vector<uint8_t>& buf
+) const {
+    const size_t end = block.start + block.length;
+    Allocation alloc;
+    allocate(block, microOps, flatBase != nullptr, alloc);
+    
+    // Load the allocated registers the block reads before writing them, and
+    // note the ones it writes
+    bool written[32] = {false};
+    bool loaded[32] = {false};
+    auto read = [&](int guest) {
+        if (alloc[guest] != NO_REG && !written[guest] && !loaded[guest]) {
+            emitRM(buf, {0x8B}, alloc[guest], guest);
+            loaded[guest] = true;
+        }
+    };
+    for (size_t pc = block.start; pc < end; pc++) {
+        const MicroOp& u = microOps[pc];
+        if (u.op == Opcode::NOP || u.op == Opcode::J) continue;
+        read(u.rs);
+        if (u.op != Opcode::ADDI && u.op != Opcode::LW) read(u.rt);
+        if (u.op != Opcode::SW && u.op != Opcode::BEQ) written[u.dest] = true;
+    }
+    
+    // Write dirty registers back, set eax to the next pc, charge the block
+    // and jump to the next block (the epilogue if the budget is used up or
+    // the next block is not compiled)
+    auto emitExit = [&](size_t next) {
+        for (int guest = 1; guest < 32; guest++) {
+            if (alloc[guest] != NO_REG && written[guest]) {
+                emitRM(buf, {0x89}, alloc[guest], guest);
+            }
+        }
+        emit8(buf, 0xB8);                              // mov eax, imm32
+        emit32(buf, static_cast<uint32_t>(next));
+        if (block.length < 128) {
+            emitBytes(buf, {0x48, 0x83, 0x2C, 0x24});  // sub qword [rsp], imm8
+            emit8(buf, static_cast<uint8_t>(block.length));
+        } else {
+            emitBytes(buf, {0x48, 0x81, 0x2C, 0x24});  // sub qword [rsp], imm32
+            emit32(buf, static_cast<uint32_t>(block.length));
+        }
+        emitBytes(buf, {0x0F, 0x8E});                  // jle epilogue
+        emit32(buf, static_cast<uint32_t>(epilogue - (base + buf.size() + 4)));
+        emitBytes(buf, {0x48, 0xB9});                  // mov rcx, &entries[next]
+        emit64(buf, reinterpret_cast<uint64_t>(&entries[next]));
+        emitBytes(buf, {0xFF, 0x21});                  // jmp [rcx]
+    };
+    
+    for (size_t pc = block.start; pc < end; pc++) {
+        const MicroOp& u = microOps[pc];
+        
+        switch (u.op) {
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::AND:
+            case Opcode::OR: {
+                uint8_t opcode = u.op == Opcode::ADD ? 0x03
+                               : u.op == Opcode::SUB ? 0x2B
+                               : u.op == Opcode::AND ? 0x23 : 0x0B;
+                loadReg(buf, alloc, u.rs);
+                emitGuestOp(buf, {opcode}, RAX, alloc, u.rt);
+                storeReg(buf, alloc, u.dest);
+                break;
+            }
+            
+            case Opcode::MUL:
+                loadReg(buf, alloc, u.rs);
+                emitGuestOp(buf, {0x0F, 0xAF}, RAX, alloc, u.rt);  // imul eax, rt
+                storeReg(buf, alloc, u.dest);
+                break;
+            
+            case Opcode::ADDI:
+                loadReg(buf, alloc, u.rs);
+                emit8(buf, 0x05);      // add eax, imm32
+                emit32(buf, static_cast<uint32_t>(u.imm));
+                storeReg(buf, alloc, u.dest);
+                break;
+            
+            case Opcode::SLL:
+            case Opcode::SRL:
+                loadReg(buf, alloc, u.rt);
+                emit8(buf, 0xC1);      // shl/shr eax, imm8
+                emit8(buf, u.op == Opcode::SLL ? 0xE0 : 0xE8);
+                emit8(buf, static_cast<uint8_t>(u.imm));
+                storeReg(buf, alloc, u.dest);
+                break;
+            
+            case Opcode::LW:
+                emitAddress(buf, alloc, u.rs, u.imm);
+                if (flatBase) {
+                    emitBytes(buf, {0x25, 0xFC, 0xFF, 0xFF, 0xFF});  // and eax, ~3
+                    emitBytes(buf, {0x41, 0x8B, 0x44, 0x05, 0x00});  // mov eax, [r13 + rax]
+                    storeReg(buf, alloc, u.dest);
+                    break;
+                }
+                emitBytes(buf, {0x89, 0xC6});          // mov esi, eax
+                emitBytes(buf, {0x4C, 0x89, 0xE7});    // mov rdi, r12
+                emitCall(buf, reinterpret_cast<const void*>(&jitLoad));
+                storeReg(buf, alloc, u.dest);
+                break;
+            
+            case Opcode::SW:
+                emitAddress(buf, alloc, u.rs, u.imm);
+                if (flatBase) {
+                    emitBytes(buf, {0x25, 0xFC, 0xFF, 0xFF, 0xFF});  // and eax, ~3
+                    emitGuestOp(buf, {0x8B}, RCX, alloc, u.rt);     // mov ecx, rt
+                    emitBytes(buf, {0x41, 0x89, 0x4C, 0x05, 0x00});  // mov [r13 + rax], ecx
+                    break;
+                }
+                emitBytes(buf, {0x89, 0xC6});          // mov esi, eax
+                emitGuestOp(buf, {0x8B}, RDX, alloc, u.rt);         // mov edx, rt
+                emitBytes(buf, {0x4C, 0x89, 0xE7});    // mov rdi, r12
+                emitCall(buf, reinterpret_cast<const void*>(&jitStore));
+                break;
+            
+            case Opcode::BEQ: {
+                loadReg(buf, alloc, u.rs);
+                emitGuestOp(buf, {0x3B}, RAX, alloc, u.rt);         // cmp eax, rt
+                emitBytes(buf, {0x0F, 0x85});          // jne to the fall-through exit
+                const size_t patch = buf.size();
+                emit32(buf, 0);
+                emitExit(u.target);
+                const uint32_t skip = static_cast<uint32_t>(buf.size() - (patch + 4));
+                memcpy(buf.data() + patch, &skip, sizeof(skip));
+                emitExit(pc + 1);
+                return;
+            }
+            
+            case Opcode::J:
+                emitExit(u.target);
+                return;
+            
+            case Opcode::NOP:
+            default:
+                break;
+        }
+    }
+    
+    emitExit(end);
+}
+
+const uint8_t* JitCompiler::install(const vector<uint8_t>& buf) {
+#ifdef JIT_X86_64
+    if (used + buf.size() > capacity) return nullptr;
+    
+    // Keep the region W^X: writable only while the new code is copied in
+    if (mprotect(code, capacity, PROT_READ | PROT_WRITE) != 0) return nullptr;
+    memcpy(code + used, buf.data(), buf.size());
+    mprotect(code, capacity, PROT_READ | PROT_EXEC);
+    
+    const uint8_t* placed = code + used;
+    // Keep entry points 16-byte aligned
+    used = (used + buf.size() + 15) & ~static_cast<size_t>(15);
+    return placed;
+#else
+    (void)buf;
+    return nullptr;
+#endif
+}
+
+const void* JitCompiler::compile(const BasicBlock& block, const vector<MicroOp>& microOps) {
+    if (!code) return nullptr;
+    
+    // Exits jump relative to the epilogue, so emit for where the block lands
+    vector<uint8_t> buf;
+    emitBlock(block, microOps, code + used, buf);
+    const uint8_t* entry = install(buf);
+    if (!entry) return nullptr;  // Out of code space, keep interpreting
+    
+    entries[block.start] = entry;
+    return entry;
+}
+
+size_t JitCompiler::run(const void* entry, int32_t* registers, GuestMemory* memory,
+                        int64_t& budget) const {
+    typedef uint64_t (*Trampoline)(int32_t*, GuestMemory*, int64_t*, const void*);
+    Trampoline enter = reinterpret_cast<Trampoline>(code);
+    return static_cast<size_t>(enter(registers, memory, &budget, entry));
+}
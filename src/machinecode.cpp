@@ -0,0 +1,180 @@
+#include "../include/machinecode.h"
+#include "../include/debug.h"
+#include <sstream>
+
+using namespace std;
+
+// Primary opcodes and SPECIAL function codes
+static const uint32_t OP_SPECIAL = 0x00;
+static const uint32_t OP_J = 0x02;
+static const uint32_t OP_BEQ = 0x04;
+static const uint32_t OP_ADDI = 0x08;
+static const uint32_t OP_ADDIU = 0x09;
+static const uint32_t OP_SPECIAL2 = 0x1C;
+static const uint32_t OP_LW = 0x23;
+static const uint32_t OP_SW = 0x2B;
+
+static const uint32_t FN_SLL = 0x00;
+static const uint32_t FN_SRL = 0x02;
+static const uint32_t FN_ADD = 0x20;
+static const uint32_t FN_ADDU = 0x21;
+static const uint32_t FN_SUB = 0x22;
+static const uint32_t FN_SUBU = 0x23;
+static const uint32_t FN_AND = 0x24;
+static const uint32_t FN_OR = 0x25;
+static const uint32_t FN_MUL = 0x02;   // SPECIAL2
+
+static uint32_t rType(uint32_t op, const Instruction& instr, uint32_t shamt, uint32_t funct) {
+    return (op << 26) | (instr.rs << 21) | (instr.rt << 16) | (instr.rd << 11) | (shamt << 6) | funct;
+}
+
+static uint32_t iType(uint32_t op, const Instruction& instr, int32_t imm) {
+    return (op << 26) | (instr.rs << 21) | (instr.rt << 16) | (imm & 0xFFFF);
+}
+
+uint32_t MachineCode::encode(const Instruction& instr, size_t pc) {
+    switch (instr.op) {
+        case Opcode::ADD:  return rType(OP_SPECIAL, instr, 0, FN_ADD);
+        case Opcode::SUB:  return rType(OP_SPECIAL, instr, 0, FN_SUB);
+        case Opcode::MUL:  return rType(OP_SPECIAL2, instr, 0, FN_MUL);
+        case Opcode::AND:  return rType(OP_SPECIAL, instr, 0, FN_AND);
+        case Opcode::OR:   return rType(OP_SPECIAL, instr, 0, FN_OR);
+        case Opcode::SLL:
+            return (instr.rt << 16) | (instr.rd << 11) | (instr.shamt << 6) | FN_SLL;
+        case Opcode::SRL:
+            return (instr.rt << 16) | (instr.rd << 11) | (instr.shamt << 6) | FN_SRL;
+        case Opcode::ADDI: return iType(OP_ADDI, instr, instr.imm);
+        case Opcode::LW:   return iType(OP_LW, instr, instr.imm);
+        case Opcode::SW:   return iType(OP_SW, instr, instr.imm);
+        case Opcode::BEQ:
+            return iType(OP_BEQ, instr, static_cast<int32_t>(instr.target - pc - 1));
+        case Opcode::J:
+            return (OP_J << 26) | (instr.target & 0x03FFFFFF);
+        case Opcode::NOP:
+            return 0;
+        default:
+            return 0xFFFFFFFF;
+    }
+}
+
+bool MachineCode::decode(uint32_t word, size_t pc, uint32_t textBase, Instruction& instr) {
+    uint32_t op = word >> 26;
+    uint32_t rs = (word >> 21) & 0x1F;
+    uint32_t rt = (word >> 16) & 0x1F;
+    uint32_t rd = (word >> 11) & 0x1F;
+    uint32_t shamt = (word >> 6) & 0x1F;
+    uint32_t funct = word & 0x3F;
+    int32_t imm = static_cast<int16_t>(word & 0xFFFF);
+
+    instr = Instruction();
+    instr.rs = rs;
+    instr.rt = rt;
+    instr.rd = rd;
+
+    if (word == 0) {
+        instr.op = Opcode::NOP;
+        instr.rs = instr.rt = instr.rd = 0;
+        return true;
+    }
+
+    switch (op) {
+        case OP_SPECIAL:
+            if (funct == FN_SLL || funct == FN_SRL) {
+                if (rs != 0) return false;   // SRL with rs=1 is ROTR
+                instr.op = (funct == FN_SLL) ? Opcode::SLL : Opcode::SRL;
+                instr.shamt = shamt;
+                instr.imm = shamt;
+                return true;
+            }
+            if (shamt != 0) return false;
+            switch (funct) {
+                case FN_ADD:
+                case FN_ADDU: instr.op = Opcode::ADD; return true;
+                case FN_SUB:
+                case FN_SUBU: instr.op = Opcode::SUB; return true;
+                case FN_AND:  instr.op = Opcode::AND; return true;
+                case FN_OR:   instr.op = Opcode::OR;  return true;
+                default:      return false;
+            }
+
+        case OP_SPECIAL2:
+            if (funct != FN_MUL || shamt != 0) return false;
+            instr.op = Opcode::MUL;
+            return true;
+
+        case OP_ADDI:
+        case OP_ADDIU:
+            instr.op = Opcode::ADDI;
+            instr.imm = imm;
+            return true;
+
+        case OP_LW:
+        case OP_SW:
+            instr.op = (op == OP_LW) ? Opcode::LW : Opcode::SW;
+            instr.imm = imm;
+            return true;
+
+        case OP_BEQ: {
+            int64_t target = static_cast<int64_t>(pc) + 1 + imm;
+            if (target < 0) return false;
+            instr.op = Opcode::BEQ;
+            instr.target = static_cast<size_t>(target);
+            return true;
+        }
+
+        case OP_J: {
+            // Region of the delay slot address, plus the 26-bit word index
+            uint32_t next = textBase + static_cast<uint32_t>(pc + 1) * 4;
+            uint32_t address = (next & 0xF0000000u) | ((word & 0x03FFFFFF) << 2);
+            if (address < textBase) return false;
+            instr.op = Opcode::J;
+            instr.rs = instr.rt = instr.rd = 0;
+            instr.target = (address - textBase) / 4;
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+string MachineCode::disassemble(const Instruction& instr, size_t pc) {
+    ostringstream out;
+    string name = opcodeToString(instr.op);
+
+    switch (instr.op) {
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::AND:
+        case Opcode::OR:
+            out << name << " " << Debug::regName(instr.rd) << ", " << Debug::regName(instr.rs)
+                << ", " << Debug::regName(instr.rt);
+            break;
+        case Opcode::SLL:
+        case Opcode::SRL:
+            out << name << " " << Debug::regName(instr.rd) << ", " << Debug::regName(instr.rt)
+                << ", " << instr.shamt;
+            break;
+        case Opcode::ADDI:
+            out << name << " " << Debug::regName(instr.rt) << ", " << Debug::regName(instr.rs)
+                << ", " << instr.imm;
+            break;
+        case Opcode::LW:
+        case Opcode::SW:
+            out << name << " " << Debug::regName(instr.rt) << ", " << instr.imm
+                << "(" << Debug::regName(instr.rs) << ")";
+            break;
+        case Opcode::BEQ:
+            out << name << " " << Debug::regName(instr.rs) << ", " << Debug::regName(instr.rt)
+                << ", " << (static_cast<int64_t>(instr.target) - static_cast<int64_t>(pc) - 1);
+            break;
+        case Opcode::J:
+            out << name << " " << instr.target;
+            break;
+        default:
+            out << name;
+            break;
+    }
+    return out.str();
+}
@@ -5,18 +5,85 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstdint>
 #include "../include/parser.h"
 #include "../include/cpu.h"
 #include "../include/errors.h"
 #include "../include/debug.h"
+#include "../include/predictor.h"
+#include "../include/cache.h"
+#include "../include/batch.h"
+#include "../include/sweep.h"
+#include "../include/counters.h"
+#include "../include/profiler.h"
+#include "../include/hoststats.h"
+#include "../include/mappedfile.h"
+#include "../include/objfile.h"
+#include "../include/binloader.h"
+#include "../include/trace.h"
+#include "../include/report.h"
 
 using namespace std;
 
 void printUsage(const char* progName) {
     cerr << "MIPS Pipeline Simulator - CS3339 Fall 2025" << endl << endl;
-    cerr << "Usage: " << progName << " <input.asm> [options]" << endl << endl;
+    cerr << "Usage: " << progName << " <input.asm|input.obj|input.elf> [options]" << endl;
+    cerr << "       " << progName << " --batch <file|glob>... [options]" << endl << endl;
     cerr << "Options:" << endl;
     cerr << "  --debug, -d    Show pipeline state after each cycle" << endl;
+    cerr << "  --mode=MODE    Simulation engine: pipeline (default), functional, threaded," << endl;
+    cerr << "                 block or jit (x86-64 Linux only)" << endl;
+    cerr << "  --no-jit       Disable native code generation (jit runs as block)" << endl;
+    cerr << "  --forwarding   Enable EX/MEM->EX and MEM/WB->EX forwarding (pipeline)" << endl;
+    cerr << "  --hazard-detect  Stall on data hazards instead of reading stale values" << endl;
+    cerr << "  --predictor=P  Branch predictor: not-taken (default), btfn, 1bit, 2bit," << endl;
+    cerr << "                 gshare or btb" << endl;
+    cerr << "  --predictor-size=N  Predictor table entries (default 1024)" << endl;
+    cerr << "  --icache=SPEC  Instruction cache timing model (pipeline)" << endl;
+    cerr << "  --dcache=SPEC  Data cache timing model (pipeline)" << endl;
+    cerr << "                 SPEC = SIZE:LINE:WAYS[:lru|fifo|random[:wb|wt[:LATENCY]]]" << endl;
+    cerr << "  --memory=M     Guest memory backend: paged (default) or flat (Linux only)" << endl;
+    cerr << "  --restore=FILE Start from a checkpoint instead of cycle 0" << endl;
+    cerr << "  --save-checkpoint=FILE  Save a checkpoint when the run ends" << endl;
+    cerr << "  --checkpoint-at=N  Fast-forward N cycles silently, save the checkpoint" << endl;
+    cerr << "                 and exit (requires --save-checkpoint)" << endl;
+    cerr << "  --trace=FILE   Write a binary execution trace (pipeline, functional or" << endl;
+    cerr << "                 threaded); decode it with mips_trace" << endl;
+    cerr << "  --profile[=FILE]  Charge cycles, stalls and flushes to the instruction" << endl;
+    cerr << "                 responsible and print a flat profile and annotated" << endl;
+    cerr << "                 listing (pipeline, functional or threaded)" << endl;
+    cerr << "  --host-stats   Report host wall time and simulated cycles and instructions" << endl;
+    cerr << "                 per second at exit" << endl;
+    cerr << "  --host-sample=N  Also time each pipeline stage and the debug output on" << endl;
+    cerr << "                 one cycle in N (implies --host-stats)" << endl;
+    cerr << "  --progress[=S] Refresh a throughput line on stderr every S seconds (default 1)" << endl;
+    cerr << "  --log-policy=P When debug/trace output falls behind: block (default)" << endl;
+    cerr << "                 waits for the writer thread, drop discards records" << endl;
+    cerr << "  --log-buffer=N Debug/trace records queued for the writer (default 8192)" << endl;
+    cerr << "  --max-cycles=N Stop the run after N cycles (default 10000)" << endl;
+    cerr << "  --stats        Print CPI, stall and branch statistics (pipeline)" << endl;
+    cerr << "  --counters=F   Print the performance counters at the end of the run as" << endl;
+    cerr << "                 json or csv" << endl;
+    cerr << "  --counters-output=FILE  Write the counters to FILE instead of stdout" << endl;
+    cerr << "  --output=F     Skip the formatted tables and write the final state and" << endl;
+    cerr << "                 statistics to stdout as json, csv or bin" << endl;
+    cerr << "  --batch        Run every input file (globs allowed) on a thread pool and" << endl;
+    cerr << "                 print one JSON record per program" << endl;
+    cerr << "  --batch-list=FILE  Read batch inputs from FILE, one per line (- for stdin)" << endl;
+    cerr << "  --jobs=N       Batch worker threads (default: one per hardware thread)" << endl;
+    cerr << "  --batch-output=FILE  Write batch records to FILE instead of stdout" << endl;
+    cerr << "  --sweep=NAME=V1,V2,...  Add a pipeline parameter to the sweep grid and" << endl;
+    cerr << "                 print one CSV row per configuration (repeatable). NAME is" << endl;
+    cerr << "                 forwarding, hazard-detect, predictor, predictor-size," << endl;
+    cerr << "                 icache or dcache (cache value none or SPEC)" << endl;
+    cerr << "  --sweep-output=FILE  Write the sweep CSV to FILE instead of stdout" << endl;
+    cerr << "  --emit-obj=FILE  Assemble to a binary object file and exit; object" << endl;
+    cerr << "                 files can be given anywhere an .asm file is accepted" << endl;
+    cerr << "  --binary[=be|le]  Treat the input as raw MIPS32 machine code (default be);" << endl;
+    cerr << "                 ELF32 MIPS executables are detected without this flag" << endl;
+    cerr << "  --no-delay-slots  Run machine code whose branch delay slots hold real" << endl;
+    cerr << "                 instructions; they are not modelled, so it may misbehave" << endl;
+    cerr << "  --cross-check  Also run a reference engine and compare final state" << endl;
     cerr << "  --help, -h     Show this help message" << endl;
 }
 
@@ -30,7 +97,39 @@ int main(int argc, char* argv[]) {
     }
     
     string filename;
+    vector<string> inputs;
+    bool batchMode = false;
+    vector<string> batchLists;
+    string batchOutput;
+    BatchOptions batchOptions;
+    vector<SweepAxis> sweepAxes;
+    string emitObjPath;
+    bool flatBinary = false;
+    ByteOrder byteOrder = ByteOrder::BIG;
+    bool ignoreDelaySlots = false;
+    string sweepOutput;
     bool debugMode = false;
+    bool crossCheck = false;
+    bool noJit = false;
+    PipelineConfig pipelineConfig;
+    MemoryBackend memoryBackend = MemoryBackend::PAGED;
+    string restorePath;
+    string checkpointPath;
+    size_t checkpointAt = 0;
+    bool checkpointEarly = false;
+    string tracePath;
+    bool profile = false;
+    bool hostReport = false;
+    size_t hostSample = 0;
+    double progressInterval = 0;
+    string profilePath;
+    size_t maxCycles = 0;
+    CounterFormat counterFormat = CounterFormat::NONE;
+    string counterPath;
+    OutputFormat outputFormat = OutputFormat::TEXT;
+    LogPolicy logPolicy = LogPolicy::BLOCK;
+    size_t logBuffer = AsyncWriter<TraceRecord>::DEFAULT_CAPACITY;
+    ExecMode mode = ExecMode::PIPELINE;
     
     // Step 3: Parse/Check command line arguments
     // While parsing here, we can set flags before starting the simulation
@@ -41,6 +140,167 @@ int main(int argc, char* argv[]) {
         
         if (arg == "--debug" || arg == "-d") {
             debugMode = true;
+        } else if (arg == "--mode=pipeline") {
+            mode = ExecMode::PIPELINE;
+        } else if (arg == "--mode=functional") {
+            mode = ExecMode::FUNCTIONAL;
+        } else if (arg == "--mode=threaded") {
+            mode = ExecMode::THREADED;
+        } else if (arg == "--mode=block") {
+            mode = ExecMode::BLOCK;
+        } else if (arg == "--mode=jit") {
+            mode = ExecMode::JIT;
+        } else if (arg == "--no-jit") {
+            noJit = true;
+        } else if (arg == "--forwarding") {
+            pipelineConfig.forwarding = true;
+            pipelineConfig.reportStats = true;
+        } else if (arg == "--hazard-detect") {
+            pipelineConfig.hazardDetection = true;
+            pipelineConfig.reportStats = true;
+        } else if (arg.rfind("--predictor=", 0) == 0) {
+            if (!parsePredictorType(arg.substr(12), pipelineConfig.predictor)) {
+                cerr << "Unknown predictor: " << arg.substr(12) << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+            pipelineConfig.reportStats = true;
+        } else if (arg.rfind("--predictor-size=", 0) == 0) {
+            try {
+                pipelineConfig.predictorSize = stoul(arg.substr(17));
+            } catch (...) {
+                cerr << "Invalid predictor size: " << arg.substr(17) << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--icache=", 0) == 0 || arg.rfind("--dcache=", 0) == 0) {
+            CacheConfig& cfg = (arg[2] == 'i') ? pipelineConfig.icache : pipelineConfig.dcache;
+            if (!parseCacheConfig(arg.substr(9), cfg)) {
+                cerr << "Invalid cache spec: " << arg.substr(9) << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--memory=paged") {
+            memoryBackend = MemoryBackend::PAGED;
+        } else if (arg == "--memory=flat") {
+            memoryBackend = MemoryBackend::FLAT;
+        } else if (arg.rfind("--restore=", 0) == 0) {
+            restorePath = arg.substr(10);
+        } else if (arg.rfind("--save-checkpoint=", 0) == 0) {
+            checkpointPath = arg.substr(18);
+        } else if (arg.rfind("--checkpoint-at=", 0) == 0) {
+            try {
+                checkpointAt = stoul(arg.substr(16));
+                checkpointEarly = true;
+            } catch (...) {
+                cerr << "Invalid cycle count: " << arg.substr(16) << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            tracePath = arg.substr(8);
+        } else if (arg == "--profile") {
+            profile = true;
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            profile = true;
+            profilePath = arg.substr(10);
+        } else if (arg == "--host-stats") {
+            hostReport = true;
+        } else if (arg.rfind("--host-sample=", 0) == 0) {
+            try {
+                hostSample = stoul(arg.substr(14));
+            } catch (...) {
+                hostSample = 0;
+            }
+            if (hostSample == 0) {
+                cerr << "Invalid sample period: " << arg.substr(14) << endl;
+                return 1;
+            }
+            hostReport = true;
+        } else if (arg == "--progress") {
+            progressInterval = 1.0;
+        } else if (arg.rfind("--progress=", 0) == 0) {
+            try {
+                progressInterval = stod(arg.substr(11));
+            } catch (...) {
+                progressInterval = 0;
+            }
+            if (!(progressInterval > 0)) {
+                cerr << "Invalid progress interval: " << arg.substr(11) << endl;
+                return 1;
+            }
+        } else if (arg == "--log-policy=block") {
+            logPolicy = LogPolicy::BLOCK;
+        } else if (arg == "--log-policy=drop") {
+            logPolicy = LogPolicy::DROP;
+        } else if (arg.rfind("--log-buffer=", 0) == 0) {
+            try {
+                logBuffer = stoul(arg.substr(13));
+            } catch (...) {
+                logBuffer = 0;
+            }
+            if (logBuffer == 0) {
+                cerr << "Invalid buffer size: " << arg.substr(13) << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--max-cycles=", 0) == 0) {
+            try {
+                maxCycles = stoul(arg.substr(13));
+            } catch (...) {
+                maxCycles = 0;
+            }
+            if (maxCycles == 0) {
+                cerr << "Invalid cycle count: " << arg.substr(13) << endl;
+                return 1;
+            }
+        } else if (arg == "--stats") {
+            pipelineConfig.reportStats = true;
+        } else if (arg.rfind("--counters=", 0) == 0) {
+            if (!Counters::parseFormat(arg.substr(11), counterFormat)) {
+                cerr << "Invalid counter format: " << arg.substr(11) << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--counters-output=", 0) == 0) {
+            counterPath = arg.substr(18);
+        } else if (arg.rfind("--output=", 0) == 0) {
+            if (!StateReport::parseFormat(arg.substr(9), outputFormat)) {
+                cerr << "Invalid output format: " << arg.substr(9) << endl;
+                return 1;
+            }
+        } else if (arg == "--batch") {
+            batchMode = true;
+        } else if (arg.rfind("--batch-list=", 0) == 0) {
+            batchMode = true;
+            batchLists.push_back(arg.substr(13));
+        } else if (arg.rfind("--batch-output=", 0) == 0) {
+            batchOutput = arg.substr(15);
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            try {
+                batchOptions.jobs = stoul(arg.substr(7));
+            } catch (...) {
+                cerr << "Invalid job count: " << arg.substr(7) << endl;
+                return 1;
+            }
+        } else if (arg.rfind("--sweep=", 0) == 0) {
+            SweepAxis axis;
+            string error;
+            if (!SweepRunner::parseAxis(arg.substr(8), axis, error)) {
+                cerr << "Invalid sweep: " << error << endl;
+                return 1;
+            }
+            sweepAxes.push_back(axis);
+        } else if (arg.rfind("--sweep-output=", 0) == 0) {
+            sweepOutput = arg.substr(15);
+        } else if (arg.rfind("--emit-obj=", 0) == 0) {
+            emitObjPath = arg.substr(11);
+        } else if (arg == "--binary" || arg == "--binary=be") {
+            flatBinary = true;
+            byteOrder = ByteOrder::BIG;
+        } else if (arg == "--binary=le") {
+            flatBinary = true;
+            byteOrder = ByteOrder::LITTLE;
+        } else if (arg == "--no-delay-slots") {
+            ignoreDelaySlots = true;
+        } else if (arg == "--cross-check") {
+            crossCheck = true;
         } else if (arg == "--help" || arg == "-h") {
             printUsage(argv[0]);
             return 0;
@@ -50,9 +310,84 @@ int main(int argc, char* argv[]) {
             return 1;
         } else {
             filename = arg;
+            inputs.push_back(arg);
         }
     }
     
+    if (noJit && mode == ExecMode::JIT) {
+        mode = ExecMode::BLOCK;
+    }
+    
+    // Structured output owns stdout, so nothing else may print there
+    bool structured = outputFormat != OutputFormat::TEXT;
+    if (structured && (debugMode || crossCheck || batchMode || !sweepAxes.empty())) {
+        cerr << "Error: --output cannot be combined with --debug, --cross-check, --batch or --sweep" << endl;
+        return 1;
+    }
+    
+    // Batch mode: every input runs silently on the thread pool and reports
+    // one JSON record; nothing else is printed to stdout
+    if (batchMode) {
+        if (debugMode || crossCheck || !restorePath.empty() || !checkpointPath.empty() ||
+            !tracePath.empty() || profile) {
+            cerr << "Error: --batch cannot be combined with --debug, --cross-check, --trace, --profile or checkpoints" << endl;
+            return 1;
+        }
+        batchOptions.mode = mode;
+        batchOptions.config = pipelineConfig;
+        batchOptions.backend = memoryBackend;
+        batchOptions.flatBinary = flatBinary;
+        batchOptions.byteOrder = byteOrder;
+        batchOptions.ignoreDelaySlots = ignoreDelaySlots;
+        batchOptions.maxCycles = maxCycles;
+        
+        try {
+            vector<string> files = BatchRunner::collect(inputs, batchLists);
+            if (files.empty()) {
+                cerr << "Error: No input files matched" << endl;
+                return 1;
+            }
+            
+            ofstream outputFile;
+            if (!batchOutput.empty()) {
+                outputFile.open(batchOutput);
+                if (!outputFile) {
+                    cerr << "Error: Could not create '" << batchOutput << "'" << endl;
+                    return 1;
+                }
+            }
+            ostream& out = batchOutput.empty() ? cout : outputFile;
+            
+            size_t failures = BatchRunner::run(files, batchOptions, out);
+            cerr << "Batch: " << files.size() << " programs, " << failures << " failed" << endl;
+            return failures ? 1 : 0;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+    }
+    
+    bool sweepMode = !sweepAxes.empty();
+    if (sweepMode && (mode != ExecMode::PIPELINE || debugMode || crossCheck ||
+                      !restorePath.empty() || !checkpointPath.empty() || !tracePath.empty() || profile)) {
+        cerr << "Error: --sweep runs the pipeline engine only, without --debug, --cross-check, --trace, --profile or checkpoints" << endl;
+        return 1;
+    }
+    
+    if (!tracePath.empty() && (mode == ExecMode::BLOCK || mode == ExecMode::JIT)) {
+        cerr << "Error: --trace needs the pipeline, functional or threaded engine" << endl;
+        return 1;
+    }
+    if (profile && (mode == ExecMode::BLOCK || mode == ExecMode::JIT)) {
+        cerr << "Error: --profile needs the pipeline, functional or threaded engine" << endl;
+        return 1;
+    }
+    
+    if (checkpointEarly && checkpointPath.empty()) {
+        cerr << "Error: --checkpoint-at requires --save-checkpoint=FILE" << endl;
+        return 1;
+    }
+    
     // Step 4: Ensure the user actually provided an input file name
     if (filename.empty()) {
         // if no filename provided, print error and exit
@@ -61,20 +396,26 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    // Step 5: Try to open the input file
-    ifstream inputFile(filename);
-    if (!inputFile) {
+    // Step 5: Try to open the input file (memory-mapped, read only)
+    MappedFile inputFile;
+    if (!inputFile.open(filename)) {
         // Could not open file, print error and exit
         cerr << "Error: Could not open file '" << filename << "'" << endl;
         return 1;
     }
     
     // Runs when file is successfully opened
-    cout << "=== MIPS PIPELINE SIMULATOR ===" << endl;
-    cout << "CS3339 Fall 2025" << endl;
-    cout << "Input file: " << filename << endl;
+    // A sweep keeps stdout for its CSV and --output for its report, so the
+    // banner and status messages go to stderr
+    ostream& info = (sweepMode || structured) ? cerr : cout;
+    info << "=== MIPS PIPELINE SIMULATOR ===" << endl;
+    info << "CS3339 Fall 2025" << endl;
+    info << "Input file: " << filename << endl;
     if (debugMode) {
-        cout << "Debug mode: ENABLED" << endl;
+        info << "Debug mode: ENABLED" << endl;
+    }
+    if (mode != ExecMode::PIPELINE) {
+        info << "Engine: " << execModeToString(mode) << endl;
     }
     
     // After successfully opening the file..
@@ -83,13 +424,26 @@ int main(int argc, char* argv[]) {
     Parser parser(errorHandler);
     
     // Step 7: Parse the assembly file with parser.cpp
-    //   - Reads each line of assembly
+    //   - Walks the mapped text line by line, without copying it
     //   - Identifies labels 
     //   - Parses instructions (opcode, registers, immediates)
     //   - Creates Instruction objects with all fields filled in
+    //   - Backpatches branches/jumps to labels defined further down
     //   - Reports errors to ErrorHandler if syntax is bad
-    Program program = parser.parse(inputFile);
-    inputFile.close();
+    // Object files (--emit-obj), ELF executables and raw binaries (--binary)
+    // are loaded as is, with no parsing
+    Program loaded;
+    try {
+        if (!BinaryLoader::loadPrebuilt(inputFile, flatBinary, byteOrder, loaded, ignoreDelaySlots)) {
+            loaded = parser.parse(inputFile.text());
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    // Every CPU below (run, cross-check reference, sweep points) shares it
+    const shared_ptr<const Program> shared = make_shared<const Program>(move(loaded));
+    const Program& program = *shared;
     
     // Step 8: Check for parsing errors
     // errors.cpp checks if any errors were collected
@@ -116,16 +470,96 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    cout << "Instructions loaded: " << program.instructions.size() << endl;
+    info << "Instructions loaded: " << program.instructions.size() << endl;
+    
+    // Assemble only: write the object file and stop
+    if (!emitObjPath.empty()) {
+        try {
+            ObjectFile::write(program, emitObjPath);
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+        info << "Object file written: " << emitObjPath << endl;
+        return 0;
+    }
+    
+    // Sweep: the parsed program is shared read-only by every configuration
+    if (sweepMode) {
+        vector<PipelineConfig> configs = SweepRunner::expand(sweepAxes, pipelineConfig);
+        info << "Sweep configurations: " << configs.size() << endl;
+        
+        ofstream outputFile;
+        if (!sweepOutput.empty()) {
+            outputFile.open(sweepOutput);
+            if (!outputFile) {
+                cerr << "Error: Could not create '" << sweepOutput << "'" << endl;
+                return 1;
+            }
+        }
+        SweepRunner::run(shared, configs, memoryBackend, batchOptions.jobs, maxCycles,
+                         sweepOutput.empty() ? cout : outputFile);
+        return 0;
+    }
     
     // If Parsing Succeeds..
     // Step 9: Create the CPU simulator
     // The CPU constructor in cpu.cpp initializes:
     // - Pipeline registers (IF_ID, ID_EX, EX_MEM, MEM_WB)
     // - 32 registers, all set to 0
-    // - 1024 words of memory
+    // - Sparse paged memory covering the 32-bit address space
     try {
-        CPU cpu(program, debugMode);
+        CPU cpu(shared, debugMode, mode, pipelineConfig, memoryBackend);
+        if (memoryBackend == MemoryBackend::FLAT && !cpu.getMemory().isFlat()) {
+            cerr << "Warning: flat memory is not available on this host, using paged" << endl;
+        }
+        if (maxCycles > 0) {
+            cpu.setCycleLimit(maxCycles);
+        }
+        cpu.setLogQueue(logPolicy, logBuffer);
+        if (counterFormat == CounterFormat::NONE && !counterPath.empty()) {
+            counterFormat = CounterFormat::JSON;
+        }
+        if (structured && counterPath.empty()) {
+            counterFormat = CounterFormat::NONE;   // Already part of the report
+        }
+        cpu.setCounterReport(counterFormat, counterPath);
+        cpu.setOutputFormat(outputFormat);
+        TraceWriter traceWriter;
+        if (!tracePath.empty()) {
+            traceWriter.open(tracePath, static_cast<uint32_t>(mode),
+                             static_cast<uint32_t>(program.instructions.size()), logPolicy, logBuffer);
+            cpu.setTrace(&traceWriter);
+        }
+        Profiler profiler(program);
+        if (profile) {
+            cpu.setProfiler(&profiler);
+        }
+        HostStats hostStats;
+        if (hostReport || progressInterval > 0) {
+            hostStats.setSamplePeriod(hostSample);
+            hostStats.setProgressInterval(progressInterval);
+            cpu.setHostStats(&hostStats);
+        }
+        if (!restorePath.empty()) {
+            cpu.loadCheckpoint(restorePath);
+            info << "Restored checkpoint: " << restorePath << " (cycle "
+                 << cpu.getCycleCount() << ")" << endl;
+        }
+        
+        // Fast-forward only: run silently to the requested cycle, save and stop
+        if (checkpointEarly) {
+            cpu.advance(checkpointAt > cpu.getCycleCount() ? checkpointAt - cpu.getCycleCount() : 0);
+            cpu.saveCheckpoint(checkpointPath);
+            if (!tracePath.empty()) {
+                traceWriter.close();
+            }
+            info << "Checkpoint saved: " << checkpointPath << " (cycle "
+                 << cpu.getCycleCount() << ", " << cpu.getMemory().dirtyPageCount()
+                 << " dirty pages)" << endl;
+            return 0;
+        }
+        
         // Step 10: Run the simulation
         //   cpu.cpp: cpu.run() starts the main simulation loop
         //   - Calls stepPipeline() each cycle
@@ -143,7 +577,70 @@ int main(int argc, char* argv[]) {
         //   - Control signals
         cpu.run();
         
-        cout << endl << "=== SIMULATION COMPLETE ===" << endl;
+        if (!tracePath.empty()) {
+            traceWriter.close();
+            info << endl << "Trace written: " << tracePath << " ("
+                 << traceWriter.recordCount() << " records)" << endl;
+            if (traceWriter.droppedCount() > 0) {
+                cerr << "Warning: " << traceWriter.droppedCount()
+                     << " trace records dropped (queue full)" << endl;
+            }
+        }
+        
+        if (hostReport) {
+            hostStats.report(info);
+        }
+        
+        if (profile && profilePath.empty()) {
+            profiler.report(info);
+        } else if (profile) {
+            ofstream profileFile(profilePath);
+            profiler.report(profileFile);
+            if (!profileFile) {
+                throw runtime_error("Could not write profile '" + profilePath + "'");
+            }
+            info << endl << "Profile written: " << profilePath << endl;
+        }
+        
+        if (!checkpointPath.empty()) {
+            cpu.saveCheckpoint(checkpointPath);
+            info << endl << "Checkpoint saved: " << checkpointPath << endl;
+        }
+        
+        // Step 11 (optional): Cross-check against a reference engine
+        // Runs a fresh CPU silently and compares final registers and memory
+        // The JIT is checked against the block interpreter, the functional
+        // engine against the pipeline, every other engine against the
+        // functional engine. A pipeline reference always forwards and detects
+        // hazards: without them it computes stale values on unpadded code,
+        // which is the point of those options, not a fault in the engine
+        // under test.
+        if (crossCheck) {
+            ExecMode otherMode = ExecMode::FUNCTIONAL;
+            PipelineConfig referenceConfig = pipelineConfig;
+            if (mode == ExecMode::FUNCTIONAL) {
+                otherMode = ExecMode::PIPELINE;
+                referenceConfig.forwarding = true;
+                referenceConfig.hazardDetection = true;
+            } else if (mode == ExecMode::JIT) {
+                otherMode = ExecMode::BLOCK;  // Same blocks, interpreted
+            }
+            CPU reference(shared, false, otherMode, referenceConfig, memoryBackend);
+            // A finished run is compared with a finished reference, whatever
+            // its cycle count
+            reference.setCycleLimit(cpu.finished() ? SIZE_MAX : cpu.getCycleLimit());
+            reference.execute();
+            
+            cout << endl << "=== CROSS-CHECK (" << execModeToString(mode)
+                 << " vs " << execModeToString(otherMode) << ") ===" << endl;
+            if (!Debug::compareState(reference, cpu)) {
+                cout << "Cross-check: FAILED" << endl;
+                return 1;
+            }
+            cout << "Cross-check: PASSED" << endl;
+        }
+        
+        info << endl << "=== SIMULATION COMPLETE ===" << endl;
     } catch (const exception& e) {
         cerr << endl << "Runtime Error: " << e.what() << endl;
         return 1;
@@ -0,0 +1,67 @@
+#include "../include/mappedfile.h"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__)
+#define MAPPEDFILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() : bytes(nullptr), length(0), descriptor(-1) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+void MappedFile::close() {
+#ifdef MAPPEDFILE_MMAP
+    if (descriptor >= 0) {
+        if (bytes && length > 0) munmap(const_cast<uint8_t*>(bytes), length);
+        ::close(descriptor);
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+    descriptor = -1;
+    buffer.clear();
+}
+
+bool MappedFile::open(const string& path) {
+    close();
+
+#ifdef MAPPEDFILE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+
+    // Empty files cannot be mapped; they are simply empty
+    if (st.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        bytes = static_cast<const uint8_t*>(view);
+        length = static_cast<size_t>(st.st_size);
+    }
+    descriptor = fd;
+    return true;
+#else
+    ifstream in(path, ios::binary);
+    if (!in) return false;
+    buffer.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+#endif
+}
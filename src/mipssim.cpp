@@ -0,0 +1,59 @@
+#include "../include/mipssim.h"
+#include "../include/parser.h"
+#include "../include/errors.h"
+#include "../include/mappedfile.h"
+#include <cstdint>
+#include <stdexcept>
+
+using namespace std;
+
+Simulator::Simulator(const Program& program, const SimOptions& options)
+    : Simulator(make_shared<const Program>(program), options) {}
+
+Simulator::Simulator(shared_ptr<const Program> program, const SimOptions& options)
+    : cpu(move(program), false, options.mode, options.config, options.backend) {
+    // Every call carries its own budget
+    cpu.setCycleLimit(SIZE_MAX);
+}
+
+// Parse with a private ErrorHandler, so nothing is printed
+static Program parseChecked(string_view text) {
+    ErrorHandler errorHandler;
+    Parser parser(errorHandler);
+    Program program = parser.parse(text);
+    if (errorHandler.hasErrors()) {
+        const Error& first = errorHandler.getErrors().front();
+        throw runtime_error("Line " + to_string(first.line) + ": " + first.message);
+    }
+    if (program.instructions.empty()) {
+        throw runtime_error("No instructions found");
+    }
+    return program;
+}
+
+Program Simulator::assemble(string_view text) {
+    return parseChecked(text);
+}
+
+Program Simulator::load(const string& path, bool flat, ByteOrder order, bool ignoreDelaySlots) {
+    MappedFile file;
+    if (!file.open(path)) {
+        throw runtime_error("Could not open file '" + path + "'");
+    }
+    Program program;
+    if (BinaryLoader::loadPrebuilt(file, flat, order, program, ignoreDelaySlots)) {
+        return program;
+    }
+    return parseChecked(file.text());
+}
+
+RunResult Simulator::step(size_t cycles) {
+    return cpu.advance(cycles) ? RunResult::FINISHED : RunResult::BUDGET;
+}
+
+void Simulator::setHooks(ExecHooks* hooks) {
+    if (hooks && (cpu.getMode() == ExecMode::BLOCK || cpu.getMode() == ExecMode::JIT)) {
+        throw runtime_error("Hooks need the pipeline, functional or threaded engine");
+    }
+    cpu.setHooks(hooks);
+}
@@ -0,0 +1,212 @@
+#include "../include/objfile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+static uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+static void pad(ofstream& out, uint64_t from, uint64_t to) {
+    static const char zeros[8] = {0};
+    out.write(zeros, static_cast<streamsize>(to - from));
+}
+
+void ObjectFile::write(const Program& program, const string& path) {
+    // Labels in instruction order, so the same program always gives the same file
+    vector<pair<string, size_t>> labels(program.labels.begin(), program.labels.end());
+    sort(labels.begin(), labels.end(), [](const pair<string, size_t>& a, const pair<string, size_t>& b) {
+        return a.second != b.second ? a.second < b.second : a.first < b.first;
+    });
+
+    string strings;
+    vector<ObjectInstruction> instructions(program.instructions.size());
+    vector<ObjectLine> lines(program.instructions.size());
+    vector<ObjectLabel> labelRecords(labels.size());
+    vector<ObjectSegment> segments(program.data.size());
+    vector<int32_t> words;
+
+    for (size_t i = 0; i < program.instructions.size(); i++) {
+        const Instruction& instr = program.instructions[i];
+        ObjectInstruction& packed = instructions[i];
+        memset(&packed, 0, sizeof(packed));
+        packed.op = static_cast<uint8_t>(instr.op);
+        packed.rs = static_cast<uint8_t>(instr.rs);
+        packed.rt = static_cast<uint8_t>(instr.rt);
+        packed.rd = static_cast<uint8_t>(instr.rd);
+        packed.shamt = instr.shamt;
+        packed.imm = instr.imm;
+        packed.target = static_cast<uint32_t>(instr.target);
+
+        ObjectLine& line = lines[i];
+        memset(&line, 0, sizeof(line));
+        if (i < program.source.size()) {
+            line.textOffset = static_cast<uint32_t>(strings.size());
+            line.textLength = static_cast<uint32_t>(program.source[i].text.size());
+            line.line = program.source[i].line;
+            strings += program.source[i].text;
+        }
+    }
+
+    for (size_t i = 0; i < labels.size(); i++) {
+        ObjectLabel& label = labelRecords[i];
+        memset(&label, 0, sizeof(label));
+        label.nameOffset = static_cast<uint32_t>(strings.size());
+        label.nameLength = static_cast<uint32_t>(labels[i].first.size());
+        label.index = static_cast<uint32_t>(labels[i].second);
+        strings += labels[i].first;
+    }
+
+    for (size_t i = 0; i < program.data.size(); i++) {
+        ObjectSegment& segment = segments[i];
+        memset(&segment, 0, sizeof(segment));
+        segment.address = program.data[i].address;
+        segment.wordCount = static_cast<uint32_t>(program.data[i].words.size());
+        segment.firstWord = words.size();
+        words.insert(words.end(), program.data[i].words.begin(), program.data[i].words.end());
+    }
+
+    ObjectHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, OBJECT_MAGIC, sizeof(header.magic));
+    header.version = OBJECT_VERSION;
+    header.instructionCount = static_cast<uint32_t>(instructions.size());
+    header.labelCount = static_cast<uint32_t>(labelRecords.size());
+    header.entry = static_cast<uint32_t>(program.entry);
+    header.segmentCount = static_cast<uint32_t>(segments.size());
+    header.instructionOffset = align8(sizeof(header));
+    header.lineOffset = align8(header.instructionOffset + instructions.size() * sizeof(ObjectInstruction));
+    header.labelOffset = align8(header.lineOffset + lines.size() * sizeof(ObjectLine));
+    header.segmentOffset = align8(header.labelOffset + labelRecords.size() * sizeof(ObjectLabel));
+    header.wordOffset = align8(header.segmentOffset + segments.size() * sizeof(ObjectSegment));
+    header.wordCount = words.size();
+    header.stringOffset = align8(header.wordOffset + words.size() * sizeof(int32_t));
+    header.stringBytes = strings.size();
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Could not create object file '" + path + "'");
+    }
+
+    uint64_t offset = sizeof(header);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    pad(out, offset, header.instructionOffset);
+
+    out.write(reinterpret_cast<const char*>(instructions.data()), instructions.size() * sizeof(ObjectInstruction));
+    offset = header.instructionOffset + instructions.size() * sizeof(ObjectInstruction);
+    pad(out, offset, header.lineOffset);
+
+    out.write(reinterpret_cast<const char*>(lines.data()), lines.size() * sizeof(ObjectLine));
+    offset = header.lineOffset + lines.size() * sizeof(ObjectLine);
+    pad(out, offset, header.labelOffset);
+
+    out.write(reinterpret_cast<const char*>(labelRecords.data()), labelRecords.size() * sizeof(ObjectLabel));
+    offset = header.labelOffset + labelRecords.size() * sizeof(ObjectLabel);
+    pad(out, offset, header.segmentOffset);
+
+    out.write(reinterpret_cast<const char*>(segments.data()), segments.size() * sizeof(ObjectSegment));
+    offset = header.segmentOffset + segments.size() * sizeof(ObjectSegment);
+    pad(out, offset, header.wordOffset);
+
+    out.write(reinterpret_cast<const char*>(words.data()), words.size() * sizeof(int32_t));
+    offset = header.wordOffset + words.size() * sizeof(int32_t);
+    pad(out, offset, header.stringOffset);
+
+    out.write(strings.data(), strings.size());
+
+    if (!out) {
+        throw runtime_error("Could not write object file '" + path + "'");
+    }
+}
+
+bool ObjectFile::matches(const MappedFile& file) {
+    return file.size() >= sizeof(OBJECT_MAGIC) &&
+           memcmp(file.data(), OBJECT_MAGIC, sizeof(OBJECT_MAGIC)) == 0;
+}
+
+Program ObjectFile::load(const MappedFile& file) {
+    ObjectHeader header;
+    if (file.size() < sizeof(header)) {
+        throw runtime_error("Invalid object file: truncated header");
+    }
+    memcpy(&header, file.data(), sizeof(header));
+
+    if (memcmp(header.magic, OBJECT_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Invalid object file: bad magic");
+    }
+    if (header.version != OBJECT_VERSION) {
+        throw runtime_error("Invalid object file: unsupported version " + to_string(header.version));
+    }
+
+    uint64_t count = header.instructionCount;
+    if (header.instructionOffset + count * sizeof(ObjectInstruction) > file.size() ||
+        header.lineOffset + count * sizeof(ObjectLine) > file.size() ||
+        header.labelOffset + uint64_t(header.labelCount) * sizeof(ObjectLabel) > file.size() ||
+        header.segmentOffset + uint64_t(header.segmentCount) * sizeof(ObjectSegment) > file.size() ||
+        header.wordOffset + header.wordCount * sizeof(int32_t) > file.size() ||
+        header.stringOffset + header.stringBytes > file.size() ||
+        header.instructionOffset % 8 || header.lineOffset % 8 || header.labelOffset % 8 ||
+        header.segmentOffset % 8 || header.wordOffset % 4) {
+        throw runtime_error("Invalid object file: truncated section");
+    }
+
+    // Sections are 8-byte aligned in the mapping, so records are read in place
+    const ObjectInstruction* packed =
+        reinterpret_cast<const ObjectInstruction*>(file.data() + header.instructionOffset);
+    const ObjectLine* lines = reinterpret_cast<const ObjectLine*>(file.data() + header.lineOffset);
+    const ObjectLabel* labels = reinterpret_cast<const ObjectLabel*>(file.data() + header.labelOffset);
+    const ObjectSegment* segments =
+        reinterpret_cast<const ObjectSegment*>(file.data() + header.segmentOffset);
+    const int32_t* words = reinterpret_cast<const int32_t*>(file.data() + header.wordOffset);
+    const char* strings = reinterpret_cast<const char*>(file.data() + header.stringOffset);
+
+    auto text = [&](uint32_t offset, uint32_t length) {
+        if (uint64_t(offset) + length > header.stringBytes) {
+            throw runtime_error("Invalid object file: string out of range");
+        }
+        return string(strings + offset, length);
+    };
+
+    Program program;
+    program.instructions.resize(count);
+    program.source.resize(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const ObjectInstruction& in = packed[i];
+        if (in.op >= static_cast<uint8_t>(Opcode::UNKNOWN) || in.rs > 31 || in.rt > 31 || in.rd > 31) {
+            throw runtime_error("Invalid object file: bad instruction " + to_string(i));
+        }
+
+        Instruction& instr = program.instructions[i];
+        instr.op = static_cast<Opcode>(in.op);
+        instr.rs = in.rs;
+        instr.rt = in.rt;
+        instr.rd = in.rd;
+        instr.shamt = in.shamt;
+        instr.imm = in.imm;
+        instr.target = in.target;
+
+        program.source[i].text = text(lines[i].textOffset, lines[i].textLength);
+        program.source[i].line = lines[i].line;
+    }
+
+    for (size_t i = 0; i < header.labelCount; i++) {
+        program.labels.emplace(text(labels[i].nameOffset, labels[i].nameLength), labels[i].index);
+    }
+
+    program.data.resize(header.segmentCount);
+    for (size_t i = 0; i < header.segmentCount; i++) {
+        const ObjectSegment& in = segments[i];
+        if (in.firstWord + in.wordCount > header.wordCount || in.address % 4) {
+            throw runtime_error("Invalid object file: bad data segment " + to_string(i));
+        }
+        program.data[i].address = in.address;
+        program.data[i].words.assign(words + in.firstWord, words + in.firstWord + in.wordCount);
+    }
+    program.entry = header.entry;
+
+    return program;
+}
@@ -1,331 +1,446 @@
 #include "../include/parser.h"
-#include <sstream>
-#include <algorithm>
-#include <cctype>
-#include <regex>
+#include "../include/mappedfile.h"
+#include <iterator>
 
 using namespace std;
 
+// Keyword tables
+// Mnemonics and register names are looked up with a perfect hash: each keyword
+// owns one slot, so a lookup is one hash, one table load and one compare.
+// The multipliers were chosen by search; buildTable() checks at compile time
+// that no two keywords share a slot.
+namespace {
+struct Keyword {
+    const char* name;   // Lower case
+    int value;
+};
+
+constexpr char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+// h(s) = a*s[0] + b*s[1] + c*(s[last] ^ length) mod size, case-insensitive
+struct KeywordHash {
+    unsigned a, b, c, size;
+
+    constexpr unsigned operator()(string_view s) const {
+        unsigned first = static_cast<unsigned char>(foldCase(s[0]));
+        unsigned second = static_cast<unsigned char>(foldCase(s[s.size() > 1 ? 1 : 0]));
+        unsigned last = static_cast<unsigned char>(foldCase(s[s.size() - 1]));
+        return (a * first + b * second + c * (last ^ static_cast<unsigned>(s.size()))) % size;
+    }
+};
+
+template <size_t SIZE>
+struct KeywordTable {
+    array<int, SIZE> slots;   // Keyword index, or -1 for an empty slot
+    bool perfect;
+};
+
+template <size_t SIZE, size_t COUNT>
+constexpr KeywordTable<SIZE> buildTable(const Keyword (&keys)[COUNT], KeywordHash hash) {
+    KeywordTable<SIZE> table = {};
+    table.perfect = true;
+    for (size_t i = 0; i < SIZE; i++) table.slots[i] = -1;
+    for (size_t i = 0; i < COUNT; i++) {
+        unsigned slot = hash(keys[i].name);
+        if (table.slots[slot] != -1) table.perfect = false;
+        table.slots[slot] = static_cast<int>(i);
+    }
+    return table;
+}
+
+template <size_t SIZE, size_t COUNT>
+int lookupKeyword(string_view s, const Keyword (&keys)[COUNT], const KeywordTable<SIZE>& table,
+                  KeywordHash hash) {
+    if (s.empty()) return -1;
+    int index = table.slots[hash(s)];
+    if (index < 0) return -1;
+
+    string_view name = keys[index].name;
+    if (name.size() != s.size()) return -1;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (foldCase(s[i]) != name[i]) return -1;
+    }
+    return keys[index].value;
+}
+
+constexpr Keyword MNEMONICS[] = {
+    {"add", static_cast<int>(Opcode::ADD)},  {"addi", static_cast<int>(Opcode::ADDI)},
+    {"sub", static_cast<int>(Opcode::SUB)},  {"mul", static_cast<int>(Opcode::MUL)},
+    {"and", static_cast<int>(Opcode::AND)},  {"or", static_cast<int>(Opcode::OR)},
+    {"sll", static_cast<int>(Opcode::SLL)},  {"srl", static_cast<int>(Opcode::SRL)},
+    {"lw", static_cast<int>(Opcode::LW)},    {"sw", static_cast<int>(Opcode::SW)},
+    {"beq", static_cast<int>(Opcode::BEQ)},  {"j", static_cast<int>(Opcode::J)},
+    {"nop", static_cast<int>(Opcode::NOP)}
+};
+
+constexpr Keyword REGISTERS[] = {
+    {"zero", 0}, {"at", 1}, {"v0", 2}, {"v1", 3},
+    {"a0", 4}, {"a1", 5}, {"a2", 6}, {"a3", 7},
+    {"t0", 8}, {"t1", 9}, {"t2", 10}, {"t3", 11},
+    {"t4", 12}, {"t5", 13}, {"t6", 14}, {"t7", 15},
+    {"s0", 16}, {"s1", 17}, {"s2", 18}, {"s3", 19},
+    {"s4", 20}, {"s5", 21}, {"s6", 22}, {"s7", 23},
+    {"t8", 24}, {"t9", 25}, {"k0", 26}, {"k1", 27},
+    {"gp", 28}, {"sp", 29}, {"fp", 30}, {"ra", 31}
+};
+
+constexpr KeywordHash MNEMONIC_HASH = {8, 1, 14, 16};
+constexpr KeywordHash REGISTER_HASH = {1, 1, 14, 128};
+
+constexpr KeywordTable<16> MNEMONIC_TABLE = buildTable<16>(MNEMONICS, MNEMONIC_HASH);
+constexpr KeywordTable<128> REGISTER_TABLE = buildTable<128>(REGISTERS, REGISTER_HASH);
+
+static_assert(MNEMONIC_TABLE.perfect, "mnemonic hash has a collision");
+static_assert(REGISTER_TABLE.perfect, "register hash has a collision");
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Integer prefix of s, like stoi: optional sign, at least one digit, and any
+// trailing characters ignored. False if there are no digits or it overflows.
+bool parseInt(string_view s, int32_t& value) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < s.size() && (s[i] == '-' || s[i] == '+')) {
+        negative = (s[i] == '-');
+        i++;
+    }
+    if (i >= s.size() || !isDigit(s[i])) return false;
+
+    int64_t result = 0;
+    for (; i < s.size() && isDigit(s[i]); i++) {
+        result = result * 10 + (s[i] - '0');
+        if (result > 2147483648LL) return false;
+    }
+    if (negative) result = -result;
+    if (result > 2147483647LL) return false;
+    value = static_cast<int32_t>(result);
+    return true;
+}
+
+// Unsigned prefix of s, like stoul on an absolute jump target
+bool parseUnsigned(string_view s, size_t& value) {
+    size_t i = (!s.empty() && s[0] == '+') ? 1 : 0;
+    if (i >= s.size() || !isDigit(s[i])) return false;
+
+    uint64_t result = 0;
+    for (; i < s.size() && isDigit(s[i]); i++) {
+        result = result * 10 + (s[i] - '0');
+        if (result > 0xFFFFFFFFull) return false;
+    }
+    value = static_cast<size_t>(result);
+    return true;
+}
+}
+
 Parser::Parser(ErrorHandler& eh) : errorHandler(eh) {}
 
-string Parser::trim(const string& s) {
+string_view Parser::trim(string_view s) {
     size_t start = s.find_first_not_of(" \t\r\n");
-    if (start == string::npos) return "";
+    if (start == string_view::npos) return string_view();
     size_t end = s.find_last_not_of(" \t\r\n");
     return s.substr(start, end - start + 1);
 }
 
-string Parser::toUpper(const string& s) {
-    string result = s;
-    transform(result.begin(), result.end(), result.begin(), ::toupper);
-    return result;
-}
+int Parser::parseRegister(string_view reg, int lineNum) {
+    string_view r = trim(reg);
 
-int Parser::parseRegister(const string& reg, int lineNum) {
-    string r = trim(reg);
-    
     // Remove $ prefix if present
     if (!r.empty() && r[0] == '$') {
-        r = r.substr(1);
+        r.remove_prefix(1);
     }
-    
+
     // Handle numeric registers ($0-$31)
-    if (!r.empty() && isdigit(static_cast<unsigned char>(r[0]))) {
-        int num = stoi(r);
-        if (num < 0 || num > 31) {
-            errorHandler.addError(lineNum, "Invalid register number: " + reg);
+    if (!r.empty() && isDigit(r[0])) {
+        int32_t num = 0;
+        if (!parseInt(r, num) || num < 0 || num > 31) {
+            errorHandler.addError(lineNum, "Invalid register number: " + string(reg));
             return 0;
         }
         return num;
     }
-    
+
     // Handle named registers
-    string upper = toUpper(r);
-    
-    if (upper == "ZERO") return 0;
-    if (upper == "AT") return 1;
-    
-    // $v0-$v1
-    if (upper.length() == 2 && upper[0] == 'V') {
-        int n = upper[1] - '0';
-        if (n >= 0 && n <= 1) return 2 + n;
-    }
-    
-    // $a0-$a3
-    if (upper.length() == 2 && upper[0] == 'A') {
-        int n = upper[1] - '0';
-        if (n >= 0 && n <= 3) return 4 + n;
-    }
-    
-    // $t0-$t9
-    if (upper.length() == 2 && upper[0] == 'T') {
-        int n = upper[1] - '0';
-        if (n >= 0 && n <= 7) return 8 + n;
-        if (n == 8 || n == 9) return 24 + (n - 8);
-    }
-    
-    // $s0-$s7
-    if (upper.length() == 2 && upper[0] == 'S') {
-        int n = upper[1] - '0';
-        if (n >= 0 && n <= 7) return 16 + n;
-    }
-    
-    // $k0-$k1
-    if (upper.length() == 2 && upper[0] == 'K') {
-        int n = upper[1] - '0';
-        if (n >= 0 && n <= 1) return 26 + n;
-    }
-    
-    if (upper == "GP") return 28;
-    if (upper == "SP") return 29;
-    if (upper == "FP") return 30;
-    if (upper == "RA") return 31;
-    
-    errorHandler.addError(lineNum, "Unknown register: " + reg);
+    int num = lookupKeyword(r, REGISTERS, REGISTER_TABLE, REGISTER_HASH);
+    if (num >= 0) return num;
+
+    errorHandler.addError(lineNum, "Unknown register: " + string(reg));
     return 0;
 }
 
-Opcode Parser::parseOpcode(const string& mnemonic) {
-    string upper = toUpper(mnemonic);
-    
-    if (upper == "ADD")  return Opcode::ADD;
-    if (upper == "ADDI") return Opcode::ADDI;
-    if (upper == "SUB")  return Opcode::SUB;
-    if (upper == "MUL")  return Opcode::MUL;
-    if (upper == "AND")  return Opcode::AND;
-    if (upper == "OR")   return Opcode::OR;
-    if (upper == "SLL")  return Opcode::SLL;
-    if (upper == "SRL")  return Opcode::SRL;
-    if (upper == "LW")   return Opcode::LW;
-    if (upper == "SW")   return Opcode::SW;
-    if (upper == "BEQ")  return Opcode::BEQ;
-    if (upper == "J")    return Opcode::J;
-    if (upper == "NOP")  return Opcode::NOP;
-    
-    return Opcode::UNKNOWN;
+Opcode Parser::parseOpcode(string_view mnemonic) {
+    int op = lookupKeyword(mnemonic, MNEMONICS, MNEMONIC_TABLE, MNEMONIC_HASH);
+    return op < 0 ? Opcode::UNKNOWN : static_cast<Opcode>(op);
 }
 
-vector<string> Parser::splitOperands(const string& operandStr) {
-    vector<string> operands;
-    string current;
+// Split on commas outside parentheses; returns the operand count (only the
+// first four are stored, which is more than any instruction takes)
+size_t Parser::splitOperands(string_view operandStr, array<string_view, 4>& operands) {
+    size_t count = 0;
+    size_t start = 0;
     int parenDepth = 0;
-    
-    for (char c : operandStr) {
+
+    for (size_t i = 0; i < operandStr.size(); i++) {
+        char c = operandStr[i];
         if (c == '(') parenDepth++;
         if (c == ')') parenDepth--;
-        
+
         if (c == ',' && parenDepth == 0) {
-            operands.push_back(trim(current));
-            current.clear();
-        } else {
-            current += c;
+            if (count < operands.size()) operands[count] = trim(operandStr.substr(start, i - start));
+            count++;
+            start = i + 1;
         }
     }
-    
-    if (!current.empty()) {
-        operands.push_back(trim(current));
+
+    if (start < operandStr.size()) {
+        if (count < operands.size()) operands[count] = trim(operandStr.substr(start));
+        count++;
     }
-    
-    return operands;
+
+    return count;
 }
 
-Program Parser::parse(istream& input) {
-    program.instructions.clear();
-    program.labels.clear();
-    
-    // Store raw lines with their instruction text
-    struct LineInfo {
-        string text;
-        int srcLine;
-    };
-    vector<LineInfo> instrLines;
-    
-    string line;
-    int srcLineNum = 0;
-    size_t instrIndex = 0;
-    
-    // First pass: collect all instruction lines and labels
-    while (getline(input, line)) {
-        srcLineNum++;
-        
+void Parser::parseInstruction(string_view text, int lineNum, size_t lineIndex) {
+    // Mnemonic is the first whitespace-delimited word
+    size_t split = 0;
+    while (split < text.size() && !isSpace(text[split])) split++;
+    string_view mnemonic = text.substr(0, split);
+    string_view rest = trim(text.substr(split));
+
+    Opcode op = parseOpcode(mnemonic);
+    if (op == Opcode::UNKNOWN) {
+        errorHandler.addError(lineNum, "Unknown instruction: " + string(mnemonic));
+        return;
+    }
+
+    Instruction instr;
+    instr.op = op;
+
+    array<string_view, 4> operands;
+    size_t count = splitOperands(rest, operands);
+
+    switch (op) {
+        case Opcode::NOP:
+            break;
+
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::AND:
+        case Opcode::OR:
+            if (count != 3) {
+                errorHandler.addError(lineNum, "Expected 3 operands for " + string(mnemonic));
+                return;
+            }
+            instr.rd = parseRegister(operands[0], lineNum);
+            instr.rs = parseRegister(operands[1], lineNum);
+            instr.rt = parseRegister(operands[2], lineNum);
+            break;
+
+        case Opcode::ADDI:
+            if (count != 3) {
+                errorHandler.addError(lineNum, "Expected 3 operands for ADDI");
+                return;
+            }
+            instr.rt = parseRegister(operands[0], lineNum);
+            instr.rs = parseRegister(operands[1], lineNum);
+            if (!parseInt(operands[2], instr.imm)) {
+                errorHandler.addError(lineNum, "Invalid immediate value: " + string(operands[2]));
+            }
+            break;
+
+        case Opcode::SLL:
+        case Opcode::SRL:
+            if (count != 3) {
+                errorHandler.addError(lineNum, "Expected 3 operands for " + string(mnemonic));
+                return;
+            }
+            instr.rd = parseRegister(operands[0], lineNum);
+            instr.rt = parseRegister(operands[1], lineNum);
+            {
+                int32_t shamt = 0;
+                if (parseInt(operands[2], shamt)) {
+                    instr.shamt = shamt;
+                    instr.imm = shamt;
+                } else {
+                    errorHandler.addError(lineNum, "Invalid shift amount: " + string(operands[2]));
+                }
+            }
+            break;
+
+        case Opcode::LW:
+        case Opcode::SW:
+            if (count != 2) {
+                errorHandler.addError(lineNum, "Expected 2 operands for " + string(mnemonic));
+                return;
+            }
+            instr.rt = parseRegister(operands[0], lineNum);
+            {
+                // OFFSET(BASE): an optional minus, digits, then a non-empty base in parentheses
+                string_view operand = operands[1];
+                size_t open = operand.find('(');
+                size_t digits = (!operand.empty() && operand[0] == '-') ? 1 : 0;
+                bool valid = open != string_view::npos && open > digits &&
+                             operand.size() > open + 2 && operand.back() == ')';
+                for (size_t i = digits; valid && i < open; i++) {
+                    valid = isDigit(operand[i]);
+                }
+
+                if (valid) {
+                    string_view offset = operand.substr(0, open);
+                    if (!parseInt(offset, instr.imm)) {
+                        errorHandler.addError(lineNum, "Invalid offset: " + string(offset));
+                    }
+                    instr.rs = parseRegister(operand.substr(open + 1, operand.size() - open - 2), lineNum);
+                } else {
+                    errorHandler.addError(lineNum, "Invalid memory operand format: " + string(operand));
+                }
+            }
+            break;
+
+        case Opcode::BEQ:
+        case Opcode::J:
+            if (op == Opcode::BEQ && count != 3) {
+                errorHandler.addError(lineNum, "Expected 3 operands for BEQ");
+                return;
+            }
+            if (op == Opcode::J && count != 1) {
+                errorHandler.addError(lineNum, "Expected 1 operand for J");
+                return;
+            }
+            if (op == Opcode::BEQ) {
+                instr.rs = parseRegister(operands[0], lineNum);
+                instr.rt = parseRegister(operands[1], lineNum);
+            }
+            {
+                // Backward labels resolve now, everything else once the file is read
+                string_view label = operands[count - 1];
+                auto it = labels.find(label);
+                if (it != labels.end()) {
+                    instr.target = it->second;
+                } else {
+                    fixups.push_back({program.instructions.size(), lineIndex, label, lineNum});
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    program.instructions.push_back(instr);
+    program.source.emplace_back(string(text), lineNum);
+}
+
+// A target that is not a label is a relative offset (BEQ) or an absolute
+// instruction index (J)
+void Parser::resolveFixups() {
+    for (const Fixup& fixup : fixups) {
+        Instruction& instr = program.instructions[fixup.index];
+
+        auto it = labels.find(fixup.label);
+        if (it != labels.end()) {
+            instr.target = it->second;
+            continue;
+        }
+
+        bool resolved = false;
+        if (instr.op == Opcode::BEQ) {
+            int32_t offset = 0;
+            if (parseInt(fixup.label, offset)) {
+                instr.target = fixup.lineIndex + 1 + offset;
+                resolved = true;
+            }
+        } else {
+            resolved = parseUnsigned(fixup.label, instr.target);
+        }
+
+        if (!resolved) {
+            errorHandler.addError(fixup.line, "Undefined label: " + string(fixup.label));
+        }
+    }
+}
+
+Program Parser::parse(string_view text) {
+    program = Program();
+    labels.clear();
+    fixups.clear();
+
+    size_t pos = 0;
+    int lineNum = 0;
+    size_t lineIndex = 0;   // Instruction lines seen, labels point here
+
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == string_view::npos) eol = text.size();
+        string_view line = text.substr(pos, eol - pos);
+        pos = eol + 1;
+        lineNum++;
+
         // Remove comments
         size_t commentPos = line.find('#');
-        if (commentPos != string::npos) {
+        if (commentPos != string_view::npos) {
             line = line.substr(0, commentPos);
         }
-        
+
         line = trim(line);
         if (line.empty()) continue;
-        
+
         // Check for label
         size_t colonPos = line.find(':');
-        if (colonPos != string::npos) {
-            string label = trim(line.substr(0, colonPos));
+        if (colonPos != string_view::npos) {
+            string_view label = trim(line.substr(0, colonPos));
             if (!label.empty()) {
-                if (program.labels.count(label)) {
-                    errorHandler.addError(srcLineNum, "Duplicate label: " + label);
+                if (labels.count(label)) {
+                    errorHandler.addError(lineNum, "Duplicate label: " + string(label));
                 } else {
                     // Label points to next instruction index
-                    program.labels[label] = instrIndex;
+                    labels.emplace(label, lineIndex);
                 }
             }
             line = trim(line.substr(colonPos + 1));
             if (line.empty()) continue;
         }
-        
-        // This is an instruction line
-        instrLines.push_back({line, srcLineNum});
-        instrIndex++;
+
+        parseInstruction(line, lineNum, lineIndex);
+        lineIndex++;
     }
-    
-    // Second pass: parse instructions with label resolution
-    for (size_t i = 0; i < instrLines.size(); i++) {
-        const auto& info = instrLines[i];
-        const string& instrLine = info.text;
-        int lineNum = info.srcLine;
-        
-        istringstream iss(instrLine);
-        string mnemonic;
-        iss >> mnemonic;
-        
-        Opcode op = parseOpcode(mnemonic);
-        if (op == Opcode::UNKNOWN) {
-            errorHandler.addError(lineNum, "Unknown instruction: " + mnemonic);
-            continue;
-        }
-        
-        Instruction instr;
-        instr.op = op;
-        instr.text = instrLine;
-        
-        string rest;
-        getline(iss, rest);
-        rest = trim(rest);
-        
-        vector<string> operands = splitOperands(rest);
-        
-        switch (op) {
-            case Opcode::NOP:
-                break;
-                
-            case Opcode::ADD:
-            case Opcode::SUB:
-            case Opcode::MUL:
-            case Opcode::AND:
-            case Opcode::OR:
-                if (operands.size() != 3) {
-                    errorHandler.addError(lineNum, "Expected 3 operands for " + mnemonic);
-                    continue;
-                }
-                instr.rd = parseRegister(operands[0], lineNum);
-                instr.rs = parseRegister(operands[1], lineNum);
-                instr.rt = parseRegister(operands[2], lineNum);
-                break;
-                
-            case Opcode::ADDI:
-                if (operands.size() != 3) {
-                    errorHandler.addError(lineNum, "Expected 3 operands for ADDI");
-                    continue;
-                }
-                instr.rt = parseRegister(operands[0], lineNum);
-                instr.rs = parseRegister(operands[1], lineNum);
-                try {
-                    instr.imm = stoi(operands[2]);
-                } catch (...) {
-                    errorHandler.addError(lineNum, "Invalid immediate value: " + operands[2]);
-                }
-                break;
-                
-            case Opcode::SLL:
-            case Opcode::SRL:
-                if (operands.size() != 3) {
-                    errorHandler.addError(lineNum, "Expected 3 operands for " + mnemonic);
-                    continue;
-                }
-                instr.rd = parseRegister(operands[0], lineNum);
-                instr.rt = parseRegister(operands[1], lineNum);
-                try {
-                    instr.shamt = stoi(operands[2]);
-                    instr.imm = instr.shamt;
-                } catch (...) {
-                    errorHandler.addError(lineNum, "Invalid shift amount: " + operands[2]);
-                }
-                break;
-                
-            case Opcode::LW:
-            case Opcode::SW:
-                if (operands.size() != 2) {
-                    errorHandler.addError(lineNum, "Expected 2 operands for " + mnemonic);
-                    continue;
-                }
-                instr.rt = parseRegister(operands[0], lineNum);
-                {
-                    regex memRegex("(-?\\d+)\\((.+)\\)");
-                    smatch match;
-                    if (regex_match(operands[1], match, memRegex)) {
-                        try {
-                            instr.imm = stoi(match[1].str());
-                        } catch (...) {
-                            errorHandler.addError(lineNum, "Invalid offset: " + match[1].str());
-                        }
-                        instr.rs = parseRegister(match[2].str(), lineNum);
-                    } else {
-                        errorHandler.addError(lineNum, "Invalid memory operand format: " + operands[1]);
-                    }
-                }
-                break;
-                
-            case Opcode::BEQ:
-                if (operands.size() != 3) {
-                    errorHandler.addError(lineNum, "Expected 3 operands for BEQ");
-                    continue;
-                }
-                instr.rs = parseRegister(operands[0], lineNum);
-                instr.rt = parseRegister(operands[1], lineNum);
-                {
-                    string label = trim(operands[2]);
-                    if (program.labels.count(label)) {
-                        instr.target = program.labels[label];
-                    } else {
-                        try {
-                            int offset = stoi(label);
-                            instr.target = i + 1 + offset;
-                        } catch (...) {
-                            errorHandler.addError(lineNum, "Undefined label: " + label);
-                        }
-                    }
-                }
-                break;
-                
-            case Opcode::J:
-                if (operands.size() != 1) {
-                    errorHandler.addError(lineNum, "Expected 1 operand for J");
-                    continue;
-                }
-                {
-                    string label = trim(operands[0]);
-                    if (program.labels.count(label)) {
-                        instr.target = program.labels[label];
-                    } else {
-                        try {
-                            instr.target = stoul(label);
-                        } catch (...) {
-                            errorHandler.addError(lineNum, "Undefined label: " + label);
-                        }
-                    }
-                }
-                break;
-                
-            default:
-                break;
-        }
-        
-        program.instructions.push_back(instr);
+
+    resolveFixups();
+    errorHandler.sortByLine();
+
+    for (const auto& entry : labels) {
+        program.labels.emplace(string(entry.first), entry.second);
     }
-    
+
+    // The views point into the caller's text
+    labels.clear();
+    fixups.clear();
+
     return program;
 }
 
+Program Parser::parse(istream& input) {
+    string text((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+    return parse(string_view(text));
+}
+
+Program Parser::parseFile(const string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        errorHandler.addError(0, "Could not open file: " + path);
+        return Program();
+    }
+    return parse(file.text());
+}
+
 bool Parser::success() const {
     return !errorHandler.hasErrors();
 }
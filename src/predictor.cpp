@@ -0,0 +1,156 @@
+#include "../include/predictor.h"
+
+using namespace std;
+
+static size_t roundUpPow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+static uint8_t trainCounter(uint8_t counter, bool taken) {
+    if (taken) return counter < 3 ? counter + 1 : 3;
+    return counter > 0 ? counter - 1 : 0;
+}
+
+unique_ptr<BranchPredictor> BranchPredictor::create(PredictorType type, size_t tableSize) {
+    size_t size = roundUpPow2(tableSize == 0 ? 1 : tableSize);
+    
+    switch (type) {
+        case PredictorType::BTFN:    return unique_ptr<BranchPredictor>(new BTFNPredictor());
+        case PredictorType::ONE_BIT: return unique_ptr<BranchPredictor>(new OneBitPredictor(size));
+        case PredictorType::TWO_BIT: return unique_ptr<BranchPredictor>(new TwoBitPredictor(size));
+        case PredictorType::GSHARE:  return unique_ptr<BranchPredictor>(new GsharePredictor(size));
+        case PredictorType::BTB:     return unique_ptr<BranchPredictor>(new BTBPredictor(size));
+        case PredictorType::NOT_TAKEN:
+        default:
+            return unique_ptr<BranchPredictor>(new NotTakenPredictor());
+    }
+}
+
+// Not taken
+
+size_t NotTakenPredictor::predict(size_t pc, const Instruction&, size_t& index) {
+    index = 0;
+    return pc + 1;
+}
+
+void NotTakenPredictor::update(size_t, const Instruction&, bool, size_t, size_t) {}
+
+// BTFN
+
+size_t BTFNPredictor::predict(size_t pc, const Instruction& instr, size_t& index) {
+    index = 0;
+    return instr.target <= pc ? instr.target : pc + 1;
+}
+
+void BTFNPredictor::update(size_t, const Instruction&, bool, size_t, size_t) {}
+
+// 1-bit
+
+OneBitPredictor::OneBitPredictor(size_t tableSize)
+    : table(tableSize, false)
+    , mask(tableSize - 1)
+{}
+
+size_t OneBitPredictor::predict(size_t pc, const Instruction& instr, size_t& index) {
+    index = pc & mask;
+    return table[index] ? instr.target : pc + 1;
+}
+
+void OneBitPredictor::update(size_t, const Instruction&, bool taken, size_t, size_t index) {
+    table[index & mask] = taken;
+}
+
+// 2-bit
+
+TwoBitPredictor::TwoBitPredictor(size_t tableSize)
+    : table(tableSize, 1)
+    , mask(tableSize - 1)
+{}
+
+size_t TwoBitPredictor::predict(size_t pc, const Instruction& instr, size_t& index) {
+    index = pc & mask;
+    return table[index] >= 2 ? instr.target : pc + 1;
+}
+
+void TwoBitPredictor::update(size_t, const Instruction&, bool taken, size_t, size_t index) {
+    uint8_t& counter = table[index & mask];
+    counter = trainCounter(counter, taken);
+}
+
+// gshare
+
+GsharePredictor::GsharePredictor(size_t tableSize)
+    : table(tableSize, 1)
+    , mask(tableSize - 1)
+    , history(0)
+{}
+
+size_t GsharePredictor::predict(size_t pc, const Instruction& instr, size_t& index) {
+    index = (pc ^ history) & mask;
+    return table[index] >= 2 ? instr.target : pc + 1;
+}
+
+void GsharePredictor::update(size_t, const Instruction&, bool taken, size_t, size_t index) {
+    uint8_t& counter = table[index & mask];
+    counter = trainCounter(counter, taken);
+    history = ((history << 1) | (taken ? 1 : 0)) & mask;
+}
+
+// BTB
+
+BTBPredictor::BTBPredictor(size_t tableSize)
+    : table(tableSize)
+    , mask(tableSize - 1)
+{}
+
+size_t BTBPredictor::predict(size_t pc, const Instruction&, size_t& index) {
+    index = pc & mask;
+    const Entry& e = table[index];
+    if (e.valid && e.tag == pc && e.counter >= 2) {
+        return e.target;
+    }
+    return pc + 1;
+}
+
+void BTBPredictor::update(size_t pc, const Instruction&, bool taken, size_t target,
+                          size_t index) {
+    Entry& e = table[index & mask];
+    if (e.valid && e.tag == pc) {
+        e.counter = trainCounter(e.counter, taken);
+        if (taken) e.target = target;
+    } else if (taken) {
+        // Allocate on the first taken outcome, starting weakly taken
+        e.valid = true;
+        e.tag = pc;
+        e.target = target;
+        e.counter = 2;
+    }
+}
+
+string predictorTypeToString(PredictorType type) {
+    switch (type) {
+        case PredictorType::NOT_TAKEN: return "not-taken";
+        case PredictorType::BTFN:      return "btfn";
+        case PredictorType::ONE_BIT:   return "1bit";
+        case PredictorType::TWO_BIT:   return "2bit";
+        case PredictorType::GSHARE:    return "gshare";
+        case PredictorType::BTB:       return "btb";
+        default:                       return "unknown";
+    }
+}
+
+bool parsePredictorType(const string& name, PredictorType& type) {
+    static const PredictorType all[] = {
+        PredictorType::NOT_TAKEN, PredictorType::BTFN, PredictorType::ONE_BIT,
+        PredictorType::TWO_BIT, PredictorType::GSHARE, PredictorType::BTB
+    };
+    for (PredictorType t : all) {
+        if (predictorTypeToString(t) == name) {
+            type = t;
+            return true;
+        }
+    }
+    return false;
+}
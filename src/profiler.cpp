@@ -0,0 +1,167 @@
+#include "../include/profiler.h"
+#include "../include/debug.h"
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+static const size_t NO_CAUSE = SIZE_MAX;
+
+enum { LATCH_IF_ID, LATCH_ID_EX, LATCH_EX_MEM, LATCH_MEM_WB };
+
+Profiler::Profiler(const Program& program)
+    : entries(program.instructions.size())
+    , source(program.source)
+    , regionOf(program.instructions.size())
+    , unattributed(0)
+{
+    fill(bubbleCause, bubbleCause + 4, NO_CAUSE);
+
+    // Labels sorted by position; code before the first label is "(start)"
+    vector<pair<size_t, string>> labels;
+    for (const auto& label : program.labels) {
+        labels.push_back(make_pair(label.second, label.first));
+    }
+    sort(labels.begin(), labels.end());
+
+    string region = "(start)";
+    size_t next = 0;
+    for (size_t pc = 0; pc < regionOf.size(); pc++) {
+        while (next < labels.size() && labels[next].first <= pc) {
+            region = labels[next++].second;
+        }
+        regionOf[pc] = region;
+    }
+}
+
+void Profiler::chargeCycle(size_t pc, bool retired) {
+    if (pc >= entries.size()) {
+        unattributed++;
+        return;
+    }
+    entries[pc].cycles++;
+    if (retired) entries[pc].retired++;
+}
+
+void Profiler::chargePipeline(const PipelineStep& step) {
+    const size_t* pcs = step.latchPc;
+    if (step.frozen) {
+        chargeCycle(pcs[LATCH_EX_MEM], false);
+        entries[pcs[LATCH_EX_MEM]].stalls++;
+        return;
+    }
+
+    // WB: the retiring instruction, or whatever the bubble is charged to
+    if (step.valid[LATCH_MEM_WB]) {
+        chargeCycle(pcs[LATCH_MEM_WB], true);
+    } else if (bubbleCause[LATCH_MEM_WB] != NO_CAUSE) {
+        chargeCycle(bubbleCause[LATCH_MEM_WB], false);
+    } else {
+        size_t oldest = step.fetchPc;
+        for (int latch = LATCH_EX_MEM; latch >= LATCH_IF_ID; latch--) {
+            if (step.valid[latch]) {
+                oldest = pcs[latch];
+                break;
+            }
+        }
+        chargeCycle(oldest, false);
+    }
+
+    // Move the bubble causes down with the latches
+    const bool stalled = step.hazardStalls > 0;
+    bubbleCause[LATCH_MEM_WB] = bubbleCause[LATCH_EX_MEM];
+    bubbleCause[LATCH_EX_MEM] = bubbleCause[LATCH_ID_EX];
+    bubbleCause[LATCH_ID_EX] = stalled ? pcs[LATCH_IF_ID] : bubbleCause[LATCH_IF_ID];
+    if (!stalled) {
+        bubbleCause[LATCH_IF_ID] = step.icacheStall ? step.fetchPc : NO_CAUSE;
+    }
+    if (step.flushed) {
+        bubbleCause[LATCH_IF_ID] = pcs[LATCH_ID_EX];
+        bubbleCause[LATCH_ID_EX] = pcs[LATCH_ID_EX];
+        entries[pcs[LATCH_ID_EX]].flushes++;
+    }
+
+    if (stalled) entries[pcs[LATCH_IF_ID]].stalls += step.hazardStalls;
+    if (step.icacheStall && step.fetchPc < entries.size()) entries[step.fetchPc].stalls++;
+}
+
+size_t Profiler::totalCycles() const {
+    size_t total = unattributed;
+    for (const ProfileEntry& entry : entries) {
+        total += entry.cycles;
+    }
+    return total;
+}
+
+void Profiler::report(ostream& out, size_t top) const {
+    const size_t total = totalCycles();
+    auto percent = [total](size_t cycles) { return total ? 100.0 * cycles / total : 0.0; };
+
+    ios::fmtflags flags = out.flags();
+    out << fixed;
+
+    vector<size_t> order;
+    for (size_t pc = 0; pc < entries.size(); pc++) {
+        if (entries[pc].cycles || entries[pc].stalls || entries[pc].flushes) order.push_back(pc);
+    }
+    stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return entries[a].cycles > entries[b].cycles;
+    });
+
+    out << "\n=== PROFILE ===" << endl;
+    out << "Cycles: " << total;
+    if (unattributed) out << " (" << unattributed << " unattributed)";
+    out << endl;
+
+    out << "\n--- Flat Profile ---" << endl;
+    out << "  cycles       %   retired    CPI   stalls  flushes     PC  region / source" << endl;
+    for (size_t i = 0; i < order.size() && i < top; i++) {
+        size_t pc = order[i];
+        const ProfileEntry& entry = entries[pc];
+        out << setw(8) << entry.cycles << setw(8) << setprecision(2) << percent(entry.cycles)
+            << setw(10) << entry.retired << setw(7) << setprecision(2)
+            << (entry.retired ? double(entry.cycles) / entry.retired : 0.0)
+            << setw(9) << entry.stalls << setw(9) << entry.flushes
+            << setw(7) << pc << "  " << regionOf[pc] << ": " << Debug::sourceText(source, pc) << endl;
+    }
+    if (order.size() > top) {
+        out << "  ... " << (order.size() - top) << " more" << endl;
+    }
+
+    // Regions in program order
+    out << "\n--- Regions ---" << endl;
+    out << "  cycles       %   retired    CPI  region" << endl;
+    size_t start = 0;
+    while (start < entries.size()) {
+        size_t end = start;
+        ProfileEntry sum;
+        while (end < entries.size() && regionOf[end] == regionOf[start]) {
+            sum.cycles += entries[end].cycles;
+            sum.retired += entries[end].retired;
+            end++;
+        }
+        if (sum.cycles) {
+            out << setw(8) << sum.cycles << setw(8) << setprecision(2) << percent(sum.cycles)
+                << setw(10) << sum.retired << setw(7) << setprecision(2)
+                << (sum.retired ? double(sum.cycles) / sum.retired : 0.0)
+                << "  " << regionOf[start] << endl;
+        }
+        start = end;
+    }
+
+    out << "\n--- Annotated Listing ---" << endl;
+    for (size_t pc = 0; pc < entries.size(); pc++) {
+        if (pc == 0 || regionOf[pc] != regionOf[pc - 1]) {
+            out << regionOf[pc] << ":" << endl;
+        }
+        if (entries[pc].cycles) {
+            out << setw(7) << setprecision(2) << percent(entries[pc].cycles) << "% " << setw(8)
+                << entries[pc].cycles;
+        } else {
+            out << setw(17) << "";
+        }
+        out << "  [" << setw(4) << pc << "]  " << Debug::sourceText(source, pc) << endl;
+    }
+
+    out.flags(flags);
+}
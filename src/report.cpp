@@ -0,0 +1,303 @@
+#include "../include/report.h"
+#include "../include/counters.h"
+#include "../include/cache.h"
+#include "../include/predictor.h"
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Fixed-size staging area in front of fwrite: bytes accumulate until the
+// buffer is full, so the whole report costs a handful of write calls
+class OutputBuffer {
+private:
+    static const size_t SIZE = 64 * 1024;
+    FILE* file;
+    vector<char> data;
+    size_t used;
+
+public:
+    explicit OutputBuffer(FILE* out) : file(out), data(SIZE), used(0) {}
+
+    void append(const void* bytes, size_t size) {
+        const char* next = static_cast<const char*>(bytes);
+        while (size > 0) {
+            size_t chunk = min(size, SIZE - used);
+            memcpy(data.data() + used, next, chunk);
+            used += chunk;
+            next += chunk;
+            size -= chunk;
+            if (used == SIZE) flush();
+        }
+    }
+    void append(const char* text) { append(text, strlen(text)); }
+    void append(const string& text) { append(text.data(), text.size()); }
+    void append(uint64_t value) {
+        char digits[24];
+        append(digits, static_cast<size_t>(snprintf(digits, sizeof(digits), "%llu",
+                                                     static_cast<unsigned long long>(value))));
+    }
+    void append(int32_t value) {
+        char digits[16];
+        append(digits, static_cast<size_t>(snprintf(digits, sizeof(digits), "%d", value)));
+    }
+
+    void flush() {
+        if (used > 0 && fwrite(data.data(), 1, used, file) != used) {
+            throw runtime_error("Could not write the output report");
+        }
+        used = 0;
+    }
+    void finish() {
+        flush();
+        if (fflush(file) != 0) {
+            throw runtime_error("Could not write the output report");
+        }
+    }
+};
+
+// Calls visit(address, value) for every non-zero memory word, in address order
+template <typename Visit>
+static void forEachWord(const GuestMemory& memory, Visit visit) {
+    for (uint32_t number : memory.touchedPages()) {
+        const int32_t* words = memory.pageData(number);
+        const uint32_t base = number << GuestMemory::PAGE_BITS;
+        for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS; i++) {
+            if (words[i] != 0) {
+                visit(base + i * 4, words[i]);
+            }
+        }
+    }
+}
+
+static bool pageHasData(const int32_t* words) {
+    for (uint32_t i = 0; i < GuestMemory::PAGE_WORDS; i++) {
+        if (words[i] != 0) return true;
+    }
+    return false;
+}
+
+// Branches executed and mispredicted over every PC
+static void branchTotals(const CPU& cpu, uint64_t& executed, uint64_t& mispredicted) {
+    executed = mispredicted = 0;
+    for (const BranchStats& b : cpu.getBranchStats()) {
+        executed += b.executed;
+        mispredicted += b.mispredicted;
+    }
+}
+
+static void writeJsonCache(OutputBuffer& out, const char* name, const Cache* cache, bool& first) {
+    if (!cache) return;
+    const CacheStats& st = cache->getStats();
+    out.append(first ? "\n    \"" : ",\n    \"");
+    out.append(name);
+    out.append("\": {\"config\": \"");
+    out.append(cacheConfigToString(cache->getConfig()));
+    out.append("\", \"reads\": ");
+    out.append(static_cast<uint64_t>(st.reads));
+    out.append(", \"writes\": ");
+    out.append(static_cast<uint64_t>(st.writes));
+    out.append(", \"hits\": ");
+    out.append(static_cast<uint64_t>(st.hits));
+    out.append(", \"misses\": ");
+    out.append(static_cast<uint64_t>(st.misses));
+    out.append(", \"writebacks\": ");
+    out.append(static_cast<uint64_t>(st.writebacks));
+    out.append("}");
+    first = false;
+}
+
+static void writeJson(OutputBuffer& out, const CPU& cpu) {
+    out.append("{\n  \"engine\": \"");
+    out.append(execModeToString(cpu.getMode()));
+    out.append("\",\n  \"status\": \"");
+    out.append(cpu.finished() ? "ok" : "cycle-limit");
+    out.append("\",\n  \"cycles\": ");
+    out.append(static_cast<uint64_t>(cpu.getCycleCount()));
+    out.append(",\n  \"retired\": ");
+    out.append(static_cast<uint64_t>(cpu.getInstructionCount()));
+    out.append(",\n  \"pc\": ");
+    out.append(static_cast<uint64_t>(cpu.getPC() * 4));
+    out.append(",\n  \"registers\": [");
+    for (int i = 0; i < 32; i++) {
+        if (i) out.append(", ");
+        out.append(cpu.getRegisters()[i]);
+    }
+
+    // The same object --counters=json writes
+    ostringstream counters;
+    Counters::writeJson(counters, cpu.getCounters(), cpu.getMode());
+    string object = counters.str();
+    while (!object.empty() && object.back() == '\n') object.pop_back();
+    out.append("],\n  \"counters\": ");
+    out.append(object);
+
+    if (cpu.getICache() || cpu.getDCache()) {
+        bool first = true;
+        out.append(",\n  \"caches\": {");
+        writeJsonCache(out, "icache", cpu.getICache(), first);
+        writeJsonCache(out, "dcache", cpu.getDCache(), first);
+        out.append("\n  }");
+    }
+    if (cpu.getPredictor()) {
+        uint64_t executed, mispredicted;
+        branchTotals(cpu, executed, mispredicted);
+        out.append(",\n  \"branchPrediction\": {\"predictor\": \"");
+        out.append(cpu.getPredictor()->name());
+        out.append("\", \"branches\": ");
+        out.append(executed);
+        out.append(", \"mispredicted\": ");
+        out.append(mispredicted);
+        out.append("}");
+    }
+
+    out.append(",\n  \"memory\": [");
+    bool first = true;
+    forEachWord(cpu.getMemory(), [&](uint32_t address, int32_t value) {
+        out.append(first ? "\n    [" : ",\n    [");
+        out.append(static_cast<uint64_t>(address));
+        out.append(", ");
+        out.append(value);
+        out.append("]");
+        first = false;
+    });
+    out.append(first ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+static void csvRow(OutputBuffer& out, const char* section, const string& name, const string& value) {
+    out.append(section);
+    out.append(",");
+    out.append(name);
+    out.append(",");
+    out.append(value);
+    out.append("\n");
+}
+
+static void writeCsvCache(OutputBuffer& out, const char* name, const Cache* cache) {
+    if (!cache) return;
+    const CacheStats& st = cache->getStats();
+    const string prefix = string(name) + ".";
+    csvRow(out, "cache", prefix + "config", cacheConfigToString(cache->getConfig()));
+    csvRow(out, "cache", prefix + "reads", to_string(st.reads));
+    csvRow(out, "cache", prefix + "writes", to_string(st.writes));
+    csvRow(out, "cache", prefix + "hits", to_string(st.hits));
+    csvRow(out, "cache", prefix + "misses", to_string(st.misses));
+    csvRow(out, "cache", prefix + "writebacks", to_string(st.writebacks));
+}
+
+static void writeCsv(OutputBuffer& out, const CPU& cpu) {
+    out.append("section,name,value\n");
+    csvRow(out, "run", "engine", execModeToString(cpu.getMode()));
+    csvRow(out, "run", "status", cpu.finished() ? "ok" : "cycle-limit");
+    csvRow(out, "run", "cycles", to_string(cpu.getCycleCount()));
+    csvRow(out, "run", "retired", to_string(cpu.getInstructionCount()));
+    csvRow(out, "run", "pc", to_string(cpu.getPC() * 4));
+    for (int i = 0; i < 32; i++) {
+        csvRow(out, "register", to_string(i), to_string(cpu.getRegisters()[i]));
+    }
+
+    // The rows --counters=csv writes, minus its header
+    ostringstream counters;
+    Counters::writeCsv(counters, cpu.getCounters(), cpu.getMode());
+    string line;
+    istringstream rows(counters.str());
+    getline(rows, line);
+    while (getline(rows, line)) {
+        out.append("counter,");
+        out.append(line);
+        out.append("\n");
+    }
+
+    writeCsvCache(out, "icache", cpu.getICache());
+    writeCsvCache(out, "dcache", cpu.getDCache());
+    if (cpu.getPredictor()) {
+        uint64_t executed, mispredicted;
+        branchTotals(cpu, executed, mispredicted);
+        csvRow(out, "branch", "predictor", cpu.getPredictor()->name());
+        csvRow(out, "branch", "branches", to_string(executed));
+        csvRow(out, "branch", "mispredicted", to_string(mispredicted));
+    }
+
+    forEachWord(cpu.getMemory(), [&](uint32_t address, int32_t value) {
+        out.append("memory,");
+        out.append(static_cast<uint64_t>(address));
+        out.append(",");
+        out.append(value);
+        out.append("\n");
+    });
+}
+
+static void writeBinary(OutputBuffer& out, const CPU& cpu) {
+    OutputHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, OUTPUT_MAGIC, sizeof(header.magic));
+    header.version = OUTPUT_VERSION;
+    header.mode = static_cast<uint32_t>(cpu.getMode());
+    header.finished = cpu.finished() ? 1 : 0;
+    header.pageWords = GuestMemory::PAGE_WORDS;
+    header.countersSize = sizeof(PerfCounters);
+    header.pc = cpu.getPC() * 4;
+    header.cycleCount = cpu.getCycleCount();
+    header.instructionCount = cpu.getInstructionCount();
+    memcpy(header.registers, cpu.getRegisters().data(), sizeof(header.registers));
+    out.append(&header, sizeof(header));
+
+    // Field by field into a zeroed image, so the struct padding after
+    // instructionMix is written as zeros and identical runs give identical files
+    const PerfCounters counters = cpu.getCounters();
+    PerfCounters image;
+    memset(static_cast<void*>(&image), 0, sizeof(image));   // Trivially copyable
+    image.cycles = counters.cycles;
+    image.retired = counters.retired;
+    image.opcodes = counters.opcodes;
+    image.loads = counters.loads;
+    image.stores = counters.stores;
+    image.branchesTaken = counters.branchesTaken;
+    image.branchesNotTaken = counters.branchesNotTaken;
+    image.jumps = counters.jumps;
+    image.flushes = counters.flushes;
+    image.loadUseStalls = counters.loadUseStalls;
+    image.dataHazardStalls = counters.dataHazardStalls;
+    image.icacheStalls = counters.icacheStalls;
+    image.dcacheStalls = counters.dcacheStalls;
+    image.bubbles = counters.bubbles;
+    image.instructionMix = counters.instructionMix;
+    out.append(&image, sizeof(image));
+
+    // Whole pages straight from guest memory, no per-word formatting
+    const GuestMemory& memory = cpu.getMemory();
+    for (uint32_t number : memory.touchedPages()) {
+        const int32_t* words = memory.pageData(number);
+        if (!pageHasData(words)) continue;
+        out.append(&number, sizeof(number));
+        out.append(words, GuestMemory::PAGE_SIZE);
+    }
+    out.append(&OUTPUT_END, sizeof(OUTPUT_END));
+}
+
+bool StateReport::parseFormat(const string& text, OutputFormat& format) {
+    if (text == "json") {
+        format = OutputFormat::JSON;
+    } else if (text == "csv") {
+        format = OutputFormat::CSV;
+    } else if (text == "bin") {
+        format = OutputFormat::BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void StateReport::write(const CPU& cpu, OutputFormat format, FILE* file) {
+    OutputBuffer out(file);
+    if (format == OutputFormat::JSON) {
+        writeJson(out, cpu);
+    } else if (format == OutputFormat::CSV) {
+        writeCsv(out, cpu);
+    } else {
+        writeBinary(out, cpu);
+    }
+    out.finish();
+}
@@ -1,5 +1,4 @@
 #include "../include/stages.h"
-#include <stdexcept>
 #include <string>
 
 using namespace std;
@@ -97,11 +96,116 @@ int32_t PipelineStages::executeALU(const Instruction& instr, int32_t op1, int32_
     }
 }
 
+int32_t PipelineStages::signExtend(int32_t imm) {
+    int16_t imm16 = static_cast<int16_t>(imm & 0xFFFF);
+    return static_cast<int32_t>(imm16);
+}
+
+bool PipelineStages::readsRs(const Instruction& instr) {
+    switch (instr.op) {
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::AND:
+        case Opcode::OR:
+        case Opcode::ADDI:
+        case Opcode::LW:
+        case Opcode::SW:
+        case Opcode::BEQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool PipelineStages::readsRt(const Instruction& instr) {
+    switch (instr.op) {
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::AND:
+        case Opcode::OR:
+        case Opcode::SLL:
+        case Opcode::SRL:
+        case Opcode::SW:
+        case Opcode::BEQ:
+            return true;
+        default:
+            return false;
+    }
+}
+
+void PipelineStages::forward(
+    ID_EX& id_ex,
+    const EX_MEM& ex_mem,
+    const MEM_WB& mem_wb
+) {
+    if (!id_ex.valid) return;
+    
+    // A load's data is not available until MEM/WB, so EX/MEM only forwards ALU results
+    bool exMemFwd = ex_mem.valid && ex_mem.ctrl.regWrite && !ex_mem.ctrl.memRead
+                 && ex_mem.destReg != 0;
+    bool memWbFwd = mem_wb.valid && mem_wb.ctrl.regWrite && mem_wb.destReg != 0;
+    int32_t memWbVal = mem_wb.ctrl.memToReg ? mem_wb.memReadData : mem_wb.aluResult;
+    
+    if (exMemFwd && ex_mem.destReg == id_ex.instr.rs) {
+        id_ex.rsVal = ex_mem.aluResult;
+    } else if (memWbFwd && mem_wb.destReg == id_ex.instr.rs) {
+        id_ex.rsVal = memWbVal;
+    }
+    
+    if (exMemFwd && ex_mem.destReg == id_ex.instr.rt) {
+        id_ex.rtVal = ex_mem.aluResult;
+    } else if (memWbFwd && mem_wb.destReg == id_ex.instr.rt) {
+        id_ex.rtVal = memWbVal;
+    }
+}
+
+StallCause PipelineStages::detectHazard(
+    const IF_ID& if_id,
+    const ID_EX& id_ex,
+    const EX_MEM& ex_mem,
+    bool forwarding
+) {
+    if (!if_id.valid) return StallCause::NONE;
+    
+    const Instruction& instr = if_id.instr;
+    bool useRs = readsRs(instr) && instr.rs != 0;
+    bool useRt = readsRt(instr) && instr.rt != 0;
+    
+    auto depends = [&](int destReg) {
+        return (useRs && destReg == instr.rs) || (useRt && destReg == instr.rt);
+    };
+    
+    bool idExWrites = id_ex.valid && id_ex.ctrl.regWrite && id_ex.destReg != 0;
+    
+    if (forwarding) {
+        // Only a load right in front of its consumer cannot be bypassed
+        if (idExWrites && id_ex.ctrl.memRead && depends(id_ex.destReg)) {
+            return StallCause::LOAD_USE;
+        }
+        return StallCause::NONE;
+    }
+    
+    // Without forwarding, wait until the producer reaches WB
+    // (WB writes the register file before ID reads it in the same cycle)
+    bool exMemWrites = ex_mem.valid && ex_mem.ctrl.regWrite && ex_mem.destReg != 0;
+    if ((idExWrites && depends(id_ex.destReg)) || (exMemWrites && depends(ex_mem.destReg))) {
+        return StallCause::DATA_HAZARD;
+    }
+    return StallCause::NONE;
+}
+
 void PipelineStages::wbStage(
     const MEM_WB& mem_wb,
-    array<int32_t, 32>& registers
+    array<int32_t, 32>& registers,
+    PerfCounters& counters
 ) {
-    if (!mem_wb.valid) return;
+    if (!mem_wb.valid) {
+        counters.bubbles++;
+        return;
+    }
+    counters.opcodes[static_cast<size_t>(mem_wb.instr.op)]++;
     
     if (mem_wb.ctrl.regWrite && mem_wb.destReg != 0) {
         int32_t value = mem_wb.ctrl.memToReg 
@@ -113,7 +217,8 @@ void PipelineStages::wbStage(
 
 MEM_WB PipelineStages::memStage(
     const EX_MEM& ex_mem,
-    vector<int32_t>& memory
+    GuestMemory& memory,
+    PerfCounters& counters
 ) {
     MEM_WB next;
     
@@ -127,20 +232,11 @@ MEM_WB PipelineStages::memStage(
     next.destReg = ex_mem.destReg;
     
     if (ex_mem.ctrl.memRead) {
-        // Convert byte address to word index
-        size_t addr = static_cast<size_t>(ex_mem.aluResult) / 4;
-        if (addr >= memory.size()) {
-            throw runtime_error("Memory read out of bounds at address " + 
-                                to_string(ex_mem.aluResult));
-        }
-        next.memReadData = memory[addr];
+        next.memReadData = loadWord(memory, ex_mem.aluResult);
+        counters.loads++;
     } else if (ex_mem.ctrl.memWrite) {
-        size_t addr = static_cast<size_t>(ex_mem.aluResult) / 4;
-        if (addr >= memory.size()) {
-            throw runtime_error("Memory write out of bounds at address " + 
-                                to_string(ex_mem.aluResult));
-        }
-        memory[addr] = ex_mem.rtVal;
+        storeWord(memory, ex_mem.aluResult, ex_mem.rtVal);
+        counters.stores++;
     }
     
     return next;
@@ -149,7 +245,8 @@ MEM_WB PipelineStages::memStage(
 EX_MEM PipelineStages::exStage(
     const ID_EX& id_ex,
     bool& branchTaken,
-    size_t& branchTarget
+    size_t& branchTarget,
+    PerfCounters& counters
 ) {
     EX_MEM next;
     branchTaken = false;
@@ -171,14 +268,20 @@ EX_MEM PipelineStages::exStage(
     next.aluResult = executeALU(id_ex.instr, id_ex.rsVal, aluOp2);
     
     // Check for branch/jump
-    if (id_ex.instr.op == Opcode::BEQ && id_ex.rsVal == id_ex.rtVal) {
-        branchTaken = true;
-        branchTarget = id_ex.instr.target;
+    if (id_ex.instr.op == Opcode::BEQ) {
+        if (id_ex.rsVal == id_ex.rtVal) {
+            branchTaken = true;
+            branchTarget = id_ex.instr.target;
+            counters.branchesTaken++;
+        } else {
+            counters.branchesNotTaken++;
+        }
     }
     
     if (id_ex.instr.op == Opcode::J) {
         branchTaken = true;
         branchTarget = id_ex.instr.target;
+        counters.jumps++;
     }
     
     next.branchTaken = branchTaken;
@@ -200,6 +303,8 @@ ID_EX PipelineStages::idStage(
     next.valid = true;
     next.pc = if_id.pc;
     next.instr = instr;
+    next.predictedPc = if_id.predictedPc;
+    next.predictorIndex = if_id.predictorIndex;
     next.ctrl = generateControl(instr);
     
     // Read register values
@@ -207,8 +312,7 @@ ID_EX PipelineStages::idStage(
     next.rtVal = registers[instr.rt];
     
     // Sign extend immediate
-    int16_t imm16 = static_cast<int16_t>(instr.imm & 0xFFFF);
-    next.signExtImm = static_cast<int32_t>(imm16);
+    next.signExtImm = signExtend(instr.imm);
     
     // Determine destination register
     if (next.ctrl.regDst) {
@@ -236,6 +340,7 @@ IF_ID PipelineStages::ifStage(
     next.valid = true;
     next.pc = pc;
     next.instr = instructions[pc];
+    next.predictedPc = pc + 1;
     
     return next;
 }
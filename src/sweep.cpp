@@ -0,0 +1,208 @@
+#include "../include/sweep.h"
+#include "../include/cache.h"
+#include "../include/predictor.h"
+#include "../include/threadpool.h"
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+
+using namespace std;
+
+// Sweep results for one configuration
+namespace {
+struct SweepRow {
+    string status;
+    size_t cycles;
+    size_t retired;
+    StallStats stalls;
+    size_t branches;
+    size_t mispredicted;
+
+    SweepRow() : cycles(0), retired(0), branches(0), mispredicted(0) {}
+};
+}
+
+static bool parseSwitch(const string& value, bool& result) {
+    if (value == "on" || value == "1" || value == "true") {
+        result = true;
+        return true;
+    }
+    if (value == "off" || value == "0" || value == "false") {
+        result = false;
+        return true;
+    }
+    return false;
+}
+
+// Re-parseable cache spec for the CSV, "none" when disabled
+static string cacheSpec(const CacheConfig& cfg) {
+    if (!cfg.enabled) return "none";
+    static const char* repl[] = { "lru", "fifo", "random" };
+    ostringstream out;
+    out << cfg.size << ":" << cfg.lineSize << ":" << cfg.associativity << ":"
+        << repl[static_cast<int>(cfg.replacement)] << ":"
+        << (cfg.writePolicy == WritePolicy::WRITE_BACK ? "wb" : "wt") << ":"
+        << cfg.missLatency;
+    return out.str();
+}
+
+bool SweepRunner::applyValue(const string& name, const string& value, PipelineConfig& config) {
+    if (name == "forwarding") {
+        return parseSwitch(value, config.forwarding);
+    }
+    if (name == "hazard-detect") {
+        return parseSwitch(value, config.hazardDetection);
+    }
+    if (name == "predictor") {
+        return parsePredictorType(value, config.predictor);
+    }
+    if (name == "predictor-size") {
+        try {
+            size_t pos = 0;
+            unsigned long size = stoul(value, &pos);
+            if (pos != value.size() || size == 0) return false;
+            config.predictorSize = size;
+            return true;
+        } catch (...) {
+            return false;
+        }
+    }
+    if (name == "icache" || name == "dcache") {
+        CacheConfig& cfg = (name == "icache") ? config.icache : config.dcache;
+        if (value == "none") {
+            cfg.enabled = false;
+            return true;
+        }
+        return parseCacheConfig(value, cfg);
+    }
+    return false;
+}
+
+bool SweepRunner::parseAxis(const string& spec, SweepAxis& axis, string& error) {
+    size_t eq = spec.find('=');
+    if (eq == string::npos || eq == 0 || eq + 1 == spec.size()) {
+        error = "expected NAME=V1,V2,...: " + spec;
+        return false;
+    }
+
+    axis.name = spec.substr(0, eq);
+    axis.values.clear();
+
+    stringstream list(spec.substr(eq + 1));
+    string value;
+    while (getline(list, value, ',')) {
+        PipelineConfig scratch;
+        if (!applyValue(axis.name, value, scratch)) {
+            error = "invalid value '" + value + "' for sweep parameter '" + axis.name + "'";
+            return false;
+        }
+        axis.values.push_back(value);
+    }
+    if (axis.values.empty()) {
+        error = "no values for sweep parameter '" + axis.name + "'";
+        return false;
+    }
+    return true;
+}
+
+vector<PipelineConfig> SweepRunner::expand(const vector<SweepAxis>& axes, const PipelineConfig& base) {
+    vector<PipelineConfig> configs(1, base);
+    for (const SweepAxis& axis : axes) {
+        vector<PipelineConfig> next;
+        next.reserve(configs.size() * axis.values.size());
+        for (const PipelineConfig& config : configs) {
+            for (const string& value : axis.values) {
+                PipelineConfig point = config;
+                applyValue(axis.name, value, point);
+                next.push_back(point);
+            }
+        }
+        configs.swap(next);
+    }
+    return configs;
+}
+
+static void writeHeader(ostream& out) {
+    out << "forwarding,hazard_detect,predictor,predictor_size,icache,dcache,"
+        << "status,cycles,instructions,cpi,load_use_stalls,data_hazard_stalls,"
+        << "flushes,icache_stalls,dcache_stalls,branches,mispredicted\n";
+}
+
+static void writeRow(ostream& out, const PipelineConfig& config, const SweepRow& row) {
+    char cpi[32];
+    snprintf(cpi, sizeof(cpi), "%.4f", row.retired ? double(row.cycles) / row.retired : 0.0);
+
+    ostringstream line;
+    line << (config.forwarding ? "on" : "off") << ","
+         << (config.hazardDetection ? "on" : "off") << ","
+         << predictorTypeToString(config.predictor) << ","
+         << config.predictorSize << ","
+         << cacheSpec(config.icache) << ","
+         << cacheSpec(config.dcache) << ","
+         << row.status << ","
+         << row.cycles << ","
+         << row.retired << ","
+         << cpi << ","
+         << row.stalls.loadUse << ","
+         << row.stalls.dataHazard << ","
+         << row.stalls.flushes << ","
+         << row.stalls.icacheMiss << ","
+         << row.stalls.dcacheMiss << ","
+         << row.branches << ","
+         << row.mispredicted << "\n";
+    out << line.str();
+}
+
+static SweepRow simulate(const shared_ptr<const Program>& program, const PipelineConfig& config,
+                         MemoryBackend backend, size_t maxCycles) {
+    SweepRow row;
+    try {
+        CPU cpu(program, false, ExecMode::PIPELINE, config, backend);
+        if (maxCycles > 0) {
+            cpu.setCycleLimit(maxCycles);
+        }
+        row.status = cpu.execute() ? "ok" : "cycle-limit";
+        row.cycles = cpu.getCycleCount();
+        row.retired = cpu.getInstructionCount();
+        row.stalls = cpu.getStallStats();
+        for (const BranchStats& b : cpu.getBranchStats()) {
+            row.branches += b.executed;
+            row.mispredicted += b.mispredicted;
+        }
+    } catch (const exception&) {
+        row.status = "runtime-error";
+    }
+    return row;
+}
+
+void SweepRunner::run(shared_ptr<const Program> program, const vector<PipelineConfig>& configs,
+                      MemoryBackend backend, size_t jobs, size_t maxCycles, ostream& out) {
+    vector<SweepRow> rows(configs.size());
+    vector<bool> done(configs.size(), false);
+    size_t nextToWrite = 0;
+    mutex outputLock;
+
+    writeHeader(out);
+
+    // Every CPU holds the same read-only Program (no per-configuration copy)
+    // and keeps its own state
+    {
+        ThreadPool pool(jobs);
+        for (size_t i = 0; i < configs.size(); i++) {
+            pool.submit([&, i] {
+                SweepRow row = simulate(program, configs[i], backend, maxCycles);
+
+                lock_guard<mutex> guard(outputLock);
+                rows[i] = row;
+                done[i] = true;
+                while (nextToWrite < configs.size() && done[nextToWrite]) {
+                    writeRow(out, configs[nextToWrite], rows[nextToWrite]);
+                    nextToWrite++;
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    out.flush();
+}
@@ -0,0 +1,97 @@
+#include "../include/threadpool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(size_t count)
+    : queued(0)
+    , pending(0)
+    , nextWorker(0)
+    , stopping(false)
+{
+    if (count == 0) {
+        count = thread::hardware_concurrency();
+        if (count == 0) count = 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        workers.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread& t : threads) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    lock_guard<mutex> guard(stateLock);
+
+    Worker& worker = *workers[nextWorker];
+    nextWorker = (nextWorker + 1) % workers.size();
+    {
+        lock_guard<mutex> workerGuard(worker.lock);
+        worker.tasks.push_back(move(task));
+    }
+
+    pending++;
+    queued++;
+    wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(stateLock);
+    idle.wait(guard, [this] { return pending == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task) {
+    Worker& worker = *workers[index];
+    lock_guard<mutex> guard(worker.lock);
+    if (worker.tasks.empty()) return false;
+
+    task = move(worker.tasks.back());
+    worker.tasks.pop_back();
+    queued--;
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+    for (size_t offset = 1; offset < workers.size(); offset++) {
+        Worker& victim = *workers[(index + offset) % workers.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (victim.tasks.empty()) continue;
+
+        task = move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            task();
+
+            lock_guard<mutex> guard(stateLock);
+            if (--pending == 0) idle.notify_all();
+            continue;
+        }
+
+        // Nothing to run anywhere: sleep until submit() or shutdown
+        unique_lock<mutex> guard(stateLock);
+        wake.wait(guard, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
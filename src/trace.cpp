@@ -0,0 +1,173 @@
+#include "../include/trace.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// Worst case for one record: 2 flag bytes, 10 per 64-bit varint, 5 per
+// 32-bit zigzag field, 1 register byte
+static const size_t TRACE_RECORD_MAX = 2 + 10 + TRACE_STAGES * 5 + 1 + 5 + 5 + 5 + 5;
+
+static void putVarint(uint8_t*& out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<uint8_t>(value);
+}
+
+static void putSigned(uint8_t*& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+// Difference of two 32-bit fields, as a small signed number
+static int64_t delta(uint32_t value, uint32_t previous) {
+    return static_cast<int32_t>(value - previous);
+}
+
+TraceWriter::TraceWriter() : records(0) {}
+
+TraceWriter::~TraceWriter() {
+    if (queue) {
+        queue->close();
+    }
+}
+
+void TraceWriter::open(const string& tracePath, uint32_t mode, uint32_t programSize,
+                       LogPolicy policy, size_t capacity) {
+    path = tracePath;
+    out.open(path, ios::binary | ios::trunc);
+    if (!out) {
+        throw runtime_error("Could not create trace file '" + path + "'");
+    }
+
+    TraceHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.mode = mode;
+    header.programSize = programSize;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    state = TraceState();
+    records = 0;
+    queue.reset(new AsyncWriter<TraceRecord>(
+        [this](const TraceRecord& record, string& batch) { encode(record, batch); },
+        [this](const char* data, size_t size) { out.write(data, static_cast<streamsize>(size)); },
+        policy, capacity));
+}
+
+void TraceWriter::encode(const TraceRecord& record, string& batch) {
+    uint8_t bytes[TRACE_RECORD_MAX];
+    uint8_t* next = bytes;
+    putVarint(next, record.flags);
+    putVarint(next, record.cycle - state.cycle);
+    state.cycle = record.cycle;
+
+    for (int stage = 0; stage < TRACE_STAGES; stage++) {
+        if (record.hasStage(stage)) {
+            putSigned(next, delta(record.stagePc[stage], state.stagePc[stage]));
+            state.stagePc[stage] = record.stagePc[stage];
+        }
+    }
+    if (record.flags & TRACE_REG_WRITE) {
+        *next++ = record.reg;
+        putSigned(next, record.regValue);
+    }
+    if (record.flags & (TRACE_MEM_READ | TRACE_MEM_WRITE)) {
+        putSigned(next, delta(record.memAddress, state.memAddress));
+        putSigned(next, record.memValue);
+        state.memAddress = record.memAddress;
+    }
+    if (record.flags & TRACE_BRANCH) {
+        putSigned(next, delta(record.branchPc, state.branchPc));
+        state.branchPc = record.branchPc;
+    }
+
+    batch.append(reinterpret_cast<const char*>(bytes), static_cast<size_t>(next - bytes));
+    records++;
+}
+
+void TraceWriter::close() {
+    if (queue) {
+        queue->close();
+    }
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write trace file '" + path + "'");
+    }
+}
+
+TraceReader::TraceReader() : offset(0) {
+    memset(&header, 0, sizeof(header));
+}
+
+void TraceReader::open(const string& path) {
+    if (!file.open(path)) {
+        throw runtime_error("Could not open trace file '" + path + "'");
+    }
+    if (file.size() < sizeof(header)) {
+        throw runtime_error("Invalid trace file: truncated header");
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Invalid trace file: bad magic");
+    }
+    if (header.version != TRACE_VERSION) {
+        throw runtime_error("Invalid trace file: unsupported version " + to_string(header.version));
+    }
+    offset = sizeof(header);
+    state = TraceState();
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    const uint8_t* bytes = file.data();
+    const size_t end = file.size();
+    if (offset >= end) {
+        return false;
+    }
+
+    auto getVarint = [&]() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (offset >= end) break;
+            uint8_t byte = bytes[offset++];
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return value;
+        }
+        throw runtime_error("Invalid trace file: truncated record at byte " + to_string(offset));
+    };
+    auto getSigned = [&]() {
+        uint64_t value = getVarint();
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    };
+
+    record = TraceRecord();
+    record.flags = static_cast<uint32_t>(getVarint());
+    state.cycle += getVarint();
+    record.cycle = state.cycle;
+
+    for (int stage = 0; stage < TRACE_STAGES; stage++) {
+        if (record.hasStage(stage)) {
+            state.stagePc[stage] += static_cast<uint32_t>(getSigned());
+            record.stagePc[stage] = state.stagePc[stage];
+        }
+    }
+    if (record.flags & TRACE_REG_WRITE) {
+        if (offset >= end) {
+            throw runtime_error("Invalid trace file: truncated record at byte " + to_string(offset));
+        }
+        record.reg = bytes[offset++];
+        record.regValue = static_cast<int32_t>(getSigned());
+    }
+    if (record.flags & (TRACE_MEM_READ | TRACE_MEM_WRITE)) {
+        state.memAddress += static_cast<uint32_t>(getSigned());
+        record.memAddress = state.memAddress;
+        record.memValue = static_cast<int32_t>(getSigned());
+    }
+    if (record.flags & TRACE_BRANCH) {
+        state.branchPc += static_cast<uint32_t>(getSigned());
+        record.branchPc = state.branchPc;
+    }
+    return true;
+}
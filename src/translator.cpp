@@ -0,0 +1,161 @@
+#include "../include/translator.h"
+#include "../include/stages.h"
+
+using namespace std;
+
+// Handlers
+// Each one mirrors the matching case of PipelineStages::executeALU, with the
+// memory access and write back folded in. $zero is never a destination here:
+// Translator swaps writes to $zero for the NOP handler (or keeps $zero at 0 for LW).
+
+static size_t opNop(const MicroOp&, size_t pc, array<int32_t, 32>&, GuestMemory&) {
+    return pc + 1;
+}
+
+static size_t opAdd(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] + r[u.rt];
+    return pc + 1;
+}
+
+static size_t opAddi(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] + u.imm;
+    return pc + 1;
+}
+
+static size_t opSub(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] - r[u.rt];
+    return pc + 1;
+}
+
+static size_t opMul(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] * r[u.rt];
+    return pc + 1;
+}
+
+static size_t opAnd(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] & r[u.rt];
+    return pc + 1;
+}
+
+static size_t opOr(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rs] | r[u.rt];
+    return pc + 1;
+}
+
+static size_t opSll(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = r[u.rt] << u.imm;
+    return pc + 1;
+}
+
+static size_t opSrl(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    r[u.dest] = static_cast<int32_t>(static_cast<uint32_t>(r[u.rt]) >> u.imm);
+    return pc + 1;
+}
+
+static size_t opLw(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory& m) {
+    r[u.dest] = PipelineStages::loadWord(m, r[u.rs] + u.imm);
+    r[0] = 0;
+    return pc + 1;
+}
+
+static size_t opSw(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory& m) {
+    PipelineStages::storeWord(m, r[u.rs] + u.imm, r[u.rt]);
+    return pc + 1;
+}
+
+static size_t opBeq(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    return r[u.rs] == r[u.rt] ? u.target : pc + 1;
+}
+
+static size_t opJ(const MicroOp& u, size_t, array<int32_t, 32>&, GuestMemory&) {
+    return u.target;
+}
+
+// Superinstructions
+// The second half of the pair is the micro-op stored right after this one
+
+static size_t opAddiBeq(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory&) {
+    const MicroOp& v = (&u)[1];
+    r[u.dest] = r[u.rs] + u.imm;
+    return r[v.rs] == r[v.rt] ? v.target : pc + 2;
+}
+
+static size_t opLwAdd(const MicroOp& u, size_t pc, array<int32_t, 32>& r, GuestMemory& m) {
+    const MicroOp& v = (&u)[1];
+    r[u.dest] = PipelineStages::loadWord(m, r[u.rs] + u.imm);
+    r[0] = 0;
+    r[v.dest] = r[v.rs] + r[v.rt];
+    return pc + 2;
+}
+
+MicroOp Translator::translate(const Instruction& instr) {
+    MicroOp u;
+    ControlSignals ctrl = PipelineStages::generateControl(instr);
+    
+    u.op = instr.op;
+    u.rs = static_cast<uint8_t>(instr.rs);
+    u.rt = static_cast<uint8_t>(instr.rt);
+    u.dest = static_cast<uint8_t>(ctrl.regDst ? instr.rd : instr.rt);
+    u.imm = PipelineStages::signExtend(instr.imm);
+    u.target = instr.target;
+    
+    switch (instr.op) {
+        case Opcode::ADD:  u.handler = opAdd;  break;
+        case Opcode::ADDI: u.handler = opAddi; break;
+        case Opcode::SUB:  u.handler = opSub;  break;
+        case Opcode::MUL:  u.handler = opMul;  break;
+        case Opcode::AND:  u.handler = opAnd;  break;
+        case Opcode::OR:   u.handler = opOr;   break;
+        case Opcode::SLL:
+            u.handler = opSll;
+            u.imm = instr.imm & 0x1F;
+            break;
+        case Opcode::SRL:
+            u.handler = opSrl;
+            u.imm = instr.imm & 0x1F;
+            break;
+        case Opcode::LW:   u.handler = opLw;   break;
+        case Opcode::SW:   u.handler = opSw;   break;
+        case Opcode::BEQ:  u.handler = opBeq;  break;
+        case Opcode::J:    u.handler = opJ;    break;
+        case Opcode::NOP:
+        default:
+            u.handler = opNop;
+            break;
+    }
+    
+    // A register write to $zero has no effect, so drop the op entirely.
+    // LW keeps its handler so the memory access happens as in the other
+    // engines; opLw puts $zero back to 0 afterwards
+    if (ctrl.regWrite && u.dest == 0 && instr.op != Opcode::LW) {
+        u.handler = opNop;
+    }
+    
+    return u;
+}
+
+vector<MicroOp> Translator::translate(const vector<Instruction>& instructions) {
+    vector<MicroOp> uops;
+    uops.reserve(instructions.size());
+    for (const Instruction& instr : instructions) {
+        uops.push_back(translate(instr));
+    }
+    return uops;
+}
+
+bool Translator::fuse(const MicroOp& first, const MicroOp& second, MicroOp& fused) {
+    MicroOpHandler handler = nullptr;
+    
+    if (first.handler == opAddi && second.handler == opBeq) {
+        handler = opAddiBeq;
+    } else if (first.handler == opLw && second.handler == opAdd) {
+        handler = opLwAdd;
+    }
+    
+    if (handler == nullptr) return false;
+    
+    fused = first;
+    fused.handler = handler;
+    fused.width = 2;
+    return true;
+}
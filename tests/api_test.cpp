@@ -0,0 +1,132 @@
+// Regression tests for the libmipssim embedding API (include/mipssim.h), run
+// from the repository root by `make test` after tests/run_tests.sh
+
+#include "mipssim.h"
+#include <array>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static int passed = 0;
+static int failed = 0;
+
+static void check(bool ok, const string& name) {
+    if (ok) {
+        passed++;
+    } else {
+        failed++;
+        printf("FAIL: %s\n", name.c_str());
+    }
+}
+
+// Final state of one engine and backend (a Simulator is not copied or moved,
+// since a flat memory is registered with the fault handler by address)
+struct Final {
+    bool finished;
+    array<int32_t, 32> registers;
+    int32_t total;   // The word at 512
+};
+
+static SimOptions options(ExecMode mode, MemoryBackend backend = MemoryBackend::PAGED) {
+    SimOptions result;
+    result.mode = mode;
+    result.backend = backend;
+    result.config.forwarding = true;
+    result.config.hazardDetection = true;
+    return result;
+}
+
+static Final finish(const Program& program, ExecMode mode, MemoryBackend backend) {
+    Simulator sim(program, options(mode, backend));
+    sim.step(1000000);
+    return {sim.finished(), sim.registers(), sim.memory().load(512)};
+}
+
+class RetireCounter : public ExecHooks {
+public:
+    size_t retired = 0;
+    size_t stores = 0;
+    void onMemory(size_t, uint32_t, int32_t, bool write) override { stores += write; }
+    void onRetire(size_t, const Instruction&) override { retired++; }
+};
+
+int main() {
+    const Program program = Simulator::load("tests/loop_mem.asm");
+
+    // Every engine and backend ends in the functional engine's state
+    const Final reference = finish(program, ExecMode::FUNCTIONAL, MemoryBackend::PAGED);
+    check(reference.finished && reference.total == 576, "reference run");
+    const ExecMode modes[] = {ExecMode::PIPELINE, ExecMode::FUNCTIONAL, ExecMode::THREADED,
+                              ExecMode::BLOCK, ExecMode::JIT};
+    for (ExecMode mode : modes) {
+        for (MemoryBackend backend : {MemoryBackend::PAGED, MemoryBackend::FLAT}) {
+            Final run = finish(program, mode, backend);
+            check(run.finished && run.registers == reference.registers && run.total == 576,
+                  string("final state ") + execModeToString(mode) +
+                  (backend == MemoryBackend::FLAT ? " flat" : " paged"));
+        }
+    }
+
+    // Budgets and predicates
+    Simulator stepped(program);
+    check(stepped.step(10) == RunResult::BUDGET && stepped.cycles() == 10, "step budget");
+    const SimOptions functional = options(ExecMode::FUNCTIONAL);
+    Simulator until(program, functional);
+    RunResult why = until.runUntil([](const Simulator& s) { return s.reg(16) == 2; }, 100000);
+    check(why == RunResult::STOPPED && until.reg(16) == 2 && !until.finished(), "runUntil stop");
+    check(until.runUntil([](const Simulator&) { return false; }, 100000) == RunResult::FINISHED &&
+          until.registers() == reference.registers, "runUntil resumes to the end");
+
+    // Hooks see every retirement and store
+    Simulator hooked(program, functional);
+    RetireCounter counter;
+    hooked.setHooks(&counter);
+    hooked.step(1000000);
+    check(counter.retired == hooked.retired() && counter.stores == 65, "hooks");
+
+    // Errors throw instead of printing
+    bool threw = false;
+    try {
+        Simulator::assemble("ADD $t0, $t1\n");
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw, "assemble error throws");
+    threw = false;
+    try {
+        until.reg(32);
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    check(threw, "reg bounds check");
+    threw = false;
+    Simulator unhookable(program, options(ExecMode::BLOCK));
+    try {
+        unhookable.setHooks(&counter);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    check(threw, "block mode refuses hooks");
+
+    // Simulators on separate threads, flat ones sharing the fault handler
+    vector<thread> threads;
+    vector<int> ok(8, 0);
+    for (size_t i = 0; i < ok.size(); i++) {
+        threads.emplace_back([&, i]() {
+            MemoryBackend backend = (i % 2) ? MemoryBackend::FLAT : MemoryBackend::PAGED;
+            Final run = finish(program, modes[i % 5], backend);
+            ok[i] = run.registers == reference.registers && run.total == 576;
+        });
+    }
+    for (thread& t : threads) t.join();
+    for (size_t i = 0; i < ok.size(); i++) {
+        check(ok[i] != 0, "thread " + to_string(i));
+    }
+
+    printf("API tests: %d passed, %d failed\n", passed, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+# RAW hazard test - no NOP padding
+# Correct results need --forwarding --hazard-detect on the pipeline
+# (or any other engine); see tests/expected/hazard_raw.out
+
+        ADDI $t0, $zero, 7     # t0 = 7
+        ADDI $t1, $t0, 3       # EX/MEM -> EX: t1 = 10
+        ADD  $t2, $t0, $t1     # both operands forwarded: t2 = 17
+        SUB  $t3, $t2, $t0     # t3 = 10
+        MUL  $t4, $t3, $t3     # t4 = 100
+        NOP
+        ADD  $t5, $t4, $t1     # MEM/WB -> EX at distance 2: t5 = 110
+        SW   $t5, 64($zero)    # store data forwarded: [64] = 110
+        LW   $s0, 64($zero)    # s0 = 110
+        ADDI $s1, $s0, 1       # load-use stall: s1 = 111
+        LW   $s2, 64($zero)    # s2 = 110
+        SW   $s2, 68($zero)    # load feeding a store: [68] = 110
+        LW   $s3, 68($zero)
+        NOP
+        ADD  $s4, $s3, $s1     # load at distance 2: s4 = 221
+        ADDI $s5, $zero, 221
+        BEQ  $s4, $s5, equal   # branch on a freshly computed register
+        ADDI $s6, $zero, 1     # skipped
+        ADDI $s6, $zero, 2     # skipped
+equal:  ADDI $s7, $s4, -21     # s7 = 200
+        SW   $s7, 72($zero)    # [72] = 200
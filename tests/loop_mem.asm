@@ -0,0 +1,31 @@
+# Loop and memory test - sums an array it writes, with nested loops
+# Exercises branch prediction and the data cache
+
+        ADDI $s0, $zero, 0     # outer counter
+        ADDI $s1, $zero, 4     # outer trips
+        ADDI $t9, $zero, 0     # running total
+outer:  ADDI $t0, $zero, 0     # index
+        ADDI $t1, $zero, 16    # inner trips
+        ADDI $t2, $zero, 256   # array base
+fill:   ADD  $t3, $t0, $s0
+        SW   $t3, 0($t2)
+        ADDI $t2, $t2, 4
+        ADDI $t0, $t0, 1
+        BEQ  $t0, $t1, sum
+        J    fill
+sum:    ADDI $t0, $zero, 0
+        ADDI $t2, $zero, 256
+add:    LW   $t4, 0($t2)
+        ADD  $t9, $t9, $t4
+        ADDI $t2, $t2, 4
+        ADDI $t0, $t0, 1
+        BEQ  $t0, $t1, next
+        J    add
+next:   ADDI $s0, $s0, 1
+        BEQ  $s0, $s1, done
+        J    outer
+done:   SW   $t9, 512($zero)   # 4 * 120 + 16 * (0+1+2+3) = 576
+        SLL  $t5, $t9, 2
+        SRL  $t6, $t5, 3
+        AND  $t7, $t6, $t9
+        OR   $t8, $t7, $s1
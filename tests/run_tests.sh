@@ -0,0 +1,151 @@
+#!/bin/bash
+# Regression tests, run from the repository root by `make test`
+#
+#   expected output  --output=json of a run compared with tests/expected/NAME.out
+#                    (UPDATE=1 rewrites the expected files instead)
+#   cross-engine     final registers and memory of every engine and memory
+#                    backend compared with the functional engine
+#   round trips      checkpoints, object files and batch mode give the same
+#                    final state as a plain run
+
+SIM=./mips_sim
+PROGRAMS="tests/simple_test.asm tests/test.asm tests/hazard_raw.asm tests/loop_mem.asm"
+# data.elf: big-endian ELF that sums the eight words of .data (0x1000) twenty
+# times, stores the total at 0x1020 and adds the .rodata word at 0x2000 to
+# it in $s0 (720 and 1720); every branch and jump has a NOP delay slot
+ELF=tests/data.elf
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+pass=0
+fail=0
+
+report() {
+    if [ "$1" -eq 0 ]; then
+        pass=$((pass + 1))
+    else
+        fail=$((fail + 1))
+        echo "FAIL: $2"
+    fi
+}
+
+# Final registers and memory as CSV rows
+state() {
+    $SIM "$@" --output=csv 2>/dev/null | grep -E '^(register|memory),'
+}
+
+expect() {
+    local name=$1
+    shift
+    $SIM "$@" --output=json > "$TMP/$name.out" 2>/dev/null
+    if [ -n "$UPDATE" ]; then
+        cp "$TMP/$name.out" "tests/expected/$name.out"
+    fi
+    diff -u "tests/expected/$name.out" "$TMP/$name.out"
+    report $? "expected output $name"
+}
+
+# An empty reference means the run itself failed
+same() {
+    [ -s "$1" ] && diff -u "$1" "$2" > "$TMP/diff"
+    local status=$?
+    [ -f "$TMP/diff" ] && cat "$TMP/diff"
+    rm -f "$TMP/diff"
+    report $status "$3"
+}
+
+# Expected output
+expect hazard_raw tests/hazard_raw.asm --forwarding --hazard-detect
+expect loop_mem tests/loop_mem.asm --forwarding --hazard-detect --predictor=gshare \
+       --predictor-size=64 --icache=256:16:1 --dcache=256:16:2:lru:wb:4
+
+# Cross-engine: unpadded programs need forwarding and hazard detection on
+# the pipeline
+for prog in $PROGRAMS $ELF; do
+    state "$prog" --mode=functional > "$TMP/ref"
+    for engine in "--mode=pipeline --forwarding --hazard-detect" "--mode=threaded" \
+                  "--mode=block" "--mode=jit" "--mode=functional --memory=flat" \
+                  "--mode=pipeline --forwarding --hazard-detect --memory=flat"; do
+        state "$prog" $engine > "$TMP/got"
+        same "$TMP/ref" "$TMP/got" "cross-engine $prog $engine"
+    done
+done
+
+# --cross-check without --forwarding --hazard-detect: the reference must not
+# be a pipeline that miscomputes unpadded code
+for prog in tests/hazard_raw.asm tests/loop_mem.asm; do
+    for mode in functional threaded block jit; do
+        $SIM "$prog" --mode=$mode --cross-check 2>/dev/null | grep -q 'Cross-check: PASSED'
+        report $? "cross-check $prog --mode=$mode"
+    done
+done
+
+# Checkpoint round trip: stop part way, restore, and finish. The ELF's data
+# segments are already in memory when the checkpoint is restored.
+for prog in tests/loop_mem.asm $ELF; do
+    for engine in "--forwarding --hazard-detect" "--mode=functional" \
+                  "--mode=functional --memory=flat"; do
+        state "$prog" $engine > "$TMP/ref"
+        $SIM "$prog" $engine --checkpoint-at=150 --save-checkpoint="$TMP/ck.bin" \
+            > /dev/null 2>&1
+        state "$prog" $engine --restore="$TMP/ck.bin" > "$TMP/got"
+        same "$TMP/ref" "$TMP/got" "checkpoint round trip $prog $engine"
+    done
+done
+
+# A checkpoint whose ID/EX latch names register 64 is refused. Offsets are
+# for x86-64: the header is 208 bytes, IF_ID 64, and ID_EX.destReg is at +68
+$SIM tests/loop_mem.asm --forwarding --hazard-detect --checkpoint-at=150 \
+    --save-checkpoint="$TMP/ck.bin" > /dev/null 2>&1
+printf '\x01' | dd of="$TMP/ck.bin" bs=1 seek=272 conv=notrunc 2>/dev/null
+printf '\x40\x00\x00\x00' | dd of="$TMP/ck.bin" bs=1 seek=340 conv=notrunc 2>/dev/null
+$SIM tests/loop_mem.asm --forwarding --hazard-detect --restore="$TMP/ck.bin" 2>&1 |
+    grep -q 'truncated or corrupt'
+report $? "corrupt checkpoint latch rejected"
+
+# Machine code with work in a delay slot (beq $0,$0,1; addi $t0,$0,1;
+# addi $t1,$0,2) needs --no-delay-slots
+printf '\x10\x00\x00\x01\x20\x08\x00\x01\x20\x09\x00\x02' > "$TMP/slot.bin"
+$SIM "$TMP/slot.bin" --binary > /dev/null 2>&1
+[ $? -eq 1 ] && state "$TMP/slot.bin" --binary --no-delay-slots | grep -q '^register,9,2$'
+report $? "delay slots"
+
+# Object files load to the same program
+for prog in $PROGRAMS; do
+    $SIM "$prog" --emit-obj="$TMP/prog.obj" > /dev/null 2>&1
+    state "$prog" --mode=functional > "$TMP/ref"
+    state "$TMP/prog.obj" --mode=functional > "$TMP/got"
+    same "$TMP/ref" "$TMP/got" "object file $prog"
+done
+
+# Batch mode: every good program runs, the bad one is reported
+$SIM --batch $PROGRAMS tests/bad_test.asm --mode=functional > "$TMP/batch.jsonl" 2>/dev/null
+[ "$(grep -c '"status":"ok"' "$TMP/batch.jsonl")" -eq 4 ] &&
+    grep -q '"file":"tests/bad_test.asm","status":"parse-error"' "$TMP/batch.jsonl"
+report $? "batch mode"
+
+# An ELF entry point outside .text (here misaligned) is rejected
+cp $ELF "$TMP/entry.elf"
+printf '\x00\x40\x00\x02' | dd of="$TMP/entry.elf" bs=1 seek=24 conv=notrunc 2>/dev/null
+$SIM "$TMP/entry.elf" 2>&1 | grep -q 'entry point outside .text'
+report $? "ELF entry point checked"
+
+# The binary report is byte for byte reproducible
+$SIM tests/loop_mem.asm --mode=jit --output=bin > "$TMP/a.bin" 2>/dev/null
+$SIM tests/loop_mem.asm --mode=jit --output=bin > "$TMP/b.bin" 2>/dev/null
+[ -s "$TMP/a.bin" ] && cmp -s "$TMP/a.bin" "$TMP/b.bin"
+report $? "binary report reproducible"
+
+# Engines without an instruction mix report it as missing, not as 0
+$SIM tests/loop_mem.asm --mode=functional --counters=json 2>/dev/null | grep -q '"loads": [1-9]' &&
+    $SIM tests/loop_mem.asm --mode=jit --counters=json 2>/dev/null | grep -q '"loads": null' &&
+    $SIM tests/loop_mem.asm --mode=block --counters=csv 2>/dev/null | grep -q '^loads,$'
+report $? "counters without an instruction mix"
+
+# Assembly errors exit with status 1
+$SIM tests/bad_test.asm > /dev/null 2>&1
+[ $? -eq 1 ]
+report $? "bad input rejected"
+
+echo "Tests: $pass passed, $fail failed"
+[ "$fail" -eq 0 ]
@@ -0,0 +1,389 @@
+#include "../include/cpu.h"
+#include "../include/errors.h"
+#include "../include/parser.h"
+#include "../include/jit.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+// mips_bench: host-performance benchmark. Runs a fixed set of generated
+// kernels through every engine and prints one line per kernel and engine
+// with the median and 90th percentile host time, the simulated rate and the
+// peak RSS. Kernels and output order never change, so results from two
+// commits can be compared with diff.
+
+static const char* BENCH_FORMAT = "mips_bench 1";
+
+void printUsage(const char* progName) {
+    cerr << "MIPS Simulator Benchmark - CS3339 Fall 2025" << endl << endl;
+    cerr << "Usage: " << progName << " [options]" << endl << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --runs=N       Timed runs per kernel and engine (default 5)" << endl;
+    cerr << "  --scale=F      Multiply every kernel's size by F (default 1)" << endl;
+    cerr << "  --kernel=NAME  Only run this kernel (repeatable): loop, memstream," << endl;
+    cerr << "                 branchy, nops or parse" << endl;
+    cerr << "  --engine=NAME  Only run this engine (repeatable)" << endl;
+    cerr << "  --memory=M     Guest memory backend: paged (default) or flat" << endl;
+    cerr << "  --output=FILE  Write results to FILE instead of stdout" << endl;
+    cerr << "  --help, -h     Show this help message" << endl;
+}
+
+struct Kernel {
+    string name;
+    string (*generate)(size_t size);    // Assembly source of the given size
+    size_t size;
+    bool parseOnly;                     // Time Parser::parse instead of the engines
+};
+
+struct Measurement {
+    vector<double> millis;
+    size_t work;        // Retired instructions, or lines parsed
+    bool ok;
+
+    Measurement() : work(0), ok(true) {}
+};
+
+// ---- Kernels ----
+
+// Tight arithmetic loop, 1000 iterations per outer pass
+static string loopKernel(size_t outer) {
+    ostringstream out;
+    out << "# loop: arithmetic with a counted inner loop\n"
+        << "        ADDI $s0, $zero, " << outer << "\n"
+        << "outer:  ADDI $t0, $zero, 1000\n"
+        << "inner:  ADD  $t2, $t2, $t0\n"
+        << "        SUB  $t3, $t2, $t1\n"
+        << "        ADDI $t0, $t0, -1\n"
+        << "        BEQ  $t0, $zero, next\n"
+        << "        J    inner\n"
+        << "next:   ADDI $s0, $s0, -1\n"
+        << "        BEQ  $s0, $zero, done\n"
+        << "        J    outer\n"
+        << "done:   NOP\n";
+    return out.str();
+}
+
+// Store and load streams over a 64 KiB array
+static string memstreamKernel(size_t passes) {
+    ostringstream out;
+    out << "# memstream: SW/LW over 16384 words per pass\n"
+        << "        ADDI $s0, $zero, " << passes << "\n"
+        << "pass:   ADDI $t0, $zero, 0\n"
+        << "        ADDI $t1, $zero, 16384\n"
+        << "fill:   SW   $t1, 4096($t0)\n"
+        << "        LW   $t2, 4092($t0)\n"
+        << "        ADD  $t3, $t3, $t2\n"
+        << "        ADDI $t0, $t0, 4\n"
+        << "        ADDI $t1, $t1, -1\n"
+        << "        BEQ  $t1, $zero, end\n"
+        << "        J    fill\n"
+        << "end:    ADDI $s0, $s0, -1\n"
+        << "        BEQ  $s0, $zero, done\n"
+        << "        J    pass\n"
+        << "done:   NOP\n";
+    return out.str();
+}
+
+// Data-dependent branches on the bits of a linear congruential generator
+static string branchyKernel(size_t outer) {
+    ostringstream out;
+    out << "# branchy: unpredictable branches\n"
+        << "        ADDI $t5, $zero, 75\n"
+        << "        ADDI $t6, $zero, 1\n"
+        << "        ADDI $t1, $zero, 1\n"
+        << "        ADDI $s0, $zero, " << outer << "\n"
+        << "outer:  ADDI $t0, $zero, 1000\n"
+        << "inner:  MUL  $t1, $t1, $t5\n"
+        << "        ADDI $t1, $t1, 74\n"
+        << "        SRL  $t2, $t1, 16\n"
+        << "        AND  $t3, $t2, $t6\n"
+        << "        BEQ  $t3, $zero, even\n"
+        << "        ADDI $t4, $t4, 1\n"
+        << "        J    join\n"
+        << "even:   ADDI $t4, $t4, -1\n"
+        << "join:   SRL  $t2, $t1, 17\n"
+        << "        AND  $t3, $t2, $t6\n"
+        << "        BEQ  $t3, $zero, skip\n"
+        << "        ADD  $t7, $t7, $t1\n"
+        << "skip:   ADDI $t0, $t0, -1\n"
+        << "        BEQ  $t0, $zero, next\n"
+        << "        J    inner\n"
+        << "next:   ADDI $s0, $s0, -1\n"
+        << "        BEQ  $s0, $zero, done\n"
+        << "        J    outer\n"
+        << "done:   NOP\n";
+    return out.str();
+}
+
+// Straight-line code with NOPs between dependent instructions, in the style
+// of tests/test.asm
+static string nopsKernel(size_t groups) {
+    static const char* body[] = {
+        "        ADDI $t0, $zero, 10    # t0 = 10",
+        "        ADDI $t1, $zero, 5     # t1 = 5",
+        "        ADD  $t2, $t0, $t1",
+        "        SUB  $t3, $t2, $t1",
+        "        MUL  $t4, $t3, $t1",
+        "        SW   $t4, 0($zero)",
+        "        LW   $t5, 0($zero)",
+        "        OR   $t6, $t5, $t2",
+    };
+    string out = "# nops: NOP-padded straight-line code\n";
+    for (size_t i = 0; i < groups; i++) {
+        for (const char* line : body) {
+            out += line;
+            out += "\n        NOP\n        NOP\n        NOP\n";
+        }
+    }
+    return out;
+}
+
+// A million-line source for the assembler alone: every mnemonic, labels,
+// comments and blank lines
+static string parseKernel(size_t lines) {
+    static const char* body[] = {
+        "loop%zu: ADD  $t2, $t0, $t1    # sum",
+        "        ADDI $t3, $t2, -42",
+        "        SUB  $s1, $t3, $t0",
+        "        MUL  $s2, $s1, $t1",
+        "        AND  $t4, $s2, $t0",
+        "        OR   $t5, $t4, $t1",
+        "        SLL  $t6, $t5, 3",
+        "        SRL  $t7, $t6, 1",
+        "        SW   $t7, 16($sp)",
+        "        LW   $t8, 16($sp)",
+        "",
+        "        BEQ  $t8, $zero, loop%zu",
+        "        NOP",
+        "        J    loop%zu",
+        "# padding comment line",
+        "        NOP",
+    };
+    const size_t count = sizeof(body) / sizeof(body[0]);
+    string out;
+    out.reserve(lines * 24);
+    char line[96];
+    for (size_t i = 0; i < lines; i++) {
+        snprintf(line, sizeof(line), body[i % count], i / count);
+        out += line;
+        out += '\n';
+    }
+    return out;
+}
+
+// ---- Measurement ----
+
+static size_t peakRssKb() {
+#if defined(_WIN32)
+    return 0;
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+    return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+static double percentile(vector<double> values, double fraction) {
+    if (values.empty()) return 0.0;
+    sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    return values[min(rank, values.size() - 1)];
+}
+
+static double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+static Measurement measureParse(const string& text, size_t runs) {
+    Measurement result;
+    result.work = static_cast<size_t>(count(text.begin(), text.end(), '\n'));
+    for (size_t run = 0; run < runs; run++) {
+        ErrorHandler errorHandler;
+        Parser parser(errorHandler);
+        auto start = chrono::steady_clock::now();
+        Program program = parser.parse(string_view(text));
+        result.millis.push_back(elapsedMs(start));
+        if (errorHandler.hasErrors()) result.ok = false;
+    }
+    return result;
+}
+
+static Measurement measureRun(const shared_ptr<const Program>& program, ExecMode mode,
+                              MemoryBackend backend, size_t runs) {
+    // Forwarding and hazard detection keep the pipeline's results equal to
+    // the other engines'
+    PipelineConfig config;
+    config.forwarding = true;
+    config.hazardDetection = true;
+    config.predictor = PredictorType::TWO_BIT;
+
+    Measurement result;
+    for (size_t run = 0; run < runs; run++) {
+        CPU cpu(program, false, mode, config, backend);
+        cpu.setCycleLimit(SIZE_MAX / 2);
+        auto start = chrono::steady_clock::now();
+        bool finished = cpu.execute();
+        result.millis.push_back(elapsedMs(start));
+        result.work = cpu.getInstructionCount();
+        if (!finished) result.ok = false;
+    }
+    return result;
+}
+
+static void printResult(ostream& out, const string& kernel, const string& engine,
+                        const Measurement& result) {
+    double median = percentile(result.millis, 0.5);
+    out << left << setw(11) << kernel << setw(12) << engine << right
+        << setw(12) << result.work
+        << setw(12) << fixed << setprecision(3) << median
+        << setw(12) << percentile(result.millis, 0.9)
+        << setw(10) << setprecision(2) << (median > 0 ? result.work / (median * 1000.0) : 0.0)
+        << setw(12) << peakRssKb()
+        << (result.ok ? "" : "  FAILED") << "\n";
+    out.flush();
+}
+
+int main(int argc, char* argv[]) {
+    size_t runs = 5;
+    double scale = 1.0;
+    vector<string> kernelFilter;
+    vector<string> engineFilter;
+    MemoryBackend backend = MemoryBackend::PAGED;
+    string outputPath;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        try {
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = stoul(arg.substr(7));
+                if (runs == 0) throw invalid_argument(arg);
+            } else if (arg.rfind("--scale=", 0) == 0) {
+                scale = stod(arg.substr(8));
+                if (!(scale > 0)) throw invalid_argument(arg);
+            } else if (arg.rfind("--kernel=", 0) == 0) {
+                kernelFilter.push_back(arg.substr(9));
+            } else if (arg.rfind("--engine=", 0) == 0) {
+                engineFilter.push_back(arg.substr(9));
+            } else if (arg == "--memory=paged") {
+                backend = MemoryBackend::PAGED;
+            } else if (arg == "--memory=flat") {
+                backend = MemoryBackend::FLAT;
+            } else if (arg.rfind("--output=", 0) == 0) {
+                outputPath = arg.substr(9);
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else {
+                cerr << "Unknown option: " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            cerr << "Invalid value: " << arg << endl;
+            return 1;
+        }
+    }
+
+    auto scaled = [scale](size_t count) { return max<size_t>(1, static_cast<size_t>(count * scale)); };
+    auto selected = [](const vector<string>& filter, const string& name) {
+        return filter.empty() || find(filter.begin(), filter.end(), name) != filter.end();
+    };
+
+    // Sources are generated one at a time, so the RSS column reflects the
+    // kernels run so far rather than all of them
+    const Kernel kernels[] = {
+        {"loop", loopKernel, scaled(400), false},
+        {"memstream", memstreamKernel, scaled(20), false},
+        {"branchy", branchyKernel, scaled(150), false},
+        {"nops", nopsKernel, scaled(8000), false},
+        {"parse", parseKernel, scaled(1000000), true},
+    };
+    const ExecMode engines[] = {ExecMode::PIPELINE, ExecMode::FUNCTIONAL, ExecMode::THREADED,
+                                ExecMode::BLOCK, ExecMode::JIT};
+
+    for (const string& name : kernelFilter) {
+        if (none_of(begin(kernels), end(kernels), [&](const Kernel& k) { return k.name == name; })) {
+            cerr << "Unknown kernel: " << name << endl;
+            return 1;
+        }
+    }
+    for (const string& name : engineFilter) {
+        if (name != "parser" && none_of(begin(engines), end(engines),
+                                        [&](ExecMode m) { return execModeToString(m) == name; })) {
+            cerr << "Unknown engine: " << name << endl;
+            return 1;
+        }
+    }
+
+    ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (!outputFile) {
+            cerr << "Error: Could not create '" << outputPath << "'" << endl;
+            return 1;
+        }
+    }
+    ostream& out = outputPath.empty() ? cout : outputFile;
+
+    out << "# " << BENCH_FORMAT << ": runs=" << runs << " scale=" << scale
+        << " memory=" << (backend == MemoryBackend::FLAT ? "flat" : "paged")
+        << " jit=" << (JitCompiler::available() ? "native" : "interpreted") << "\n"
+        << "# work = retired instructions (parse: source lines); rate = million per second\n"
+        << "# peak_rss_kb is the process high-water mark after the row\n"
+        << "# " << left << setw(9) << "kernel" << setw(12) << "engine" << right
+        << setw(12) << "work" << setw(12) << "median_ms" << setw(12) << "p90_ms"
+        << setw(10) << "rate" << setw(12) << "peak_rss_kb" << "\n";
+
+    bool failed = false;
+    for (const Kernel& kernel : kernels) {
+        if (!selected(kernelFilter, kernel.name)) continue;
+        const string text = kernel.generate(kernel.size);
+
+        if (kernel.parseOnly) {
+            if (!selected(engineFilter, "parser")) continue;
+            Measurement result = measureParse(text, runs);
+            printResult(out, kernel.name, "parser", result);
+            failed = failed || !result.ok;
+            continue;
+        }
+
+        ErrorHandler errorHandler;
+        Parser parser(errorHandler);
+        const shared_ptr<const Program> program =
+            make_shared<const Program>(parser.parse(string_view(text)));
+        if (errorHandler.hasErrors()) {
+            errorHandler.printErrors();
+            return 1;
+        }
+        for (ExecMode mode : engines) {
+            if (!selected(engineFilter, execModeToString(mode))) continue;
+            try {
+                Measurement result = measureRun(program, mode, backend, runs);
+                printResult(out, kernel.name, execModeToString(mode), result);
+                failed = failed || !result.ok;
+            } catch (const exception& e) {
+                cerr << "Error: " << kernel.name << " on " << execModeToString(mode) << ": "
+                     << e.what() << endl;
+                failed = true;
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
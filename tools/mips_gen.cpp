@@ -0,0 +1,353 @@
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// mips_gen: synthetic workload generator. Writes assembly in the tests/*.asm
+// dialect: a sequence of loop nests whose innermost bodies are random
+// instructions drawn from a weighted mix, with forward branches, a chosen
+// dependency distance and loads and stores spread over a memory footprint.
+// Every loop counts down and every branch in a body jumps forward, so the
+// program always terminates. The same options and seed give the same file on
+// every host.
+
+void printUsage(const char* progName) {
+    cerr << "MIPS Workload Generator - CS3339 Fall 2025" << endl << endl;
+    cerr << "Usage: " << progName << " [options]" << endl << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --size=N          Static instructions to generate (default 1000)" << endl;
+    cerr << "  --body=N          Instructions per innermost loop body (default 32)" << endl;
+    cerr << "  --depth=N         Loop nesting depth, 0-6 (default 2)" << endl;
+    cerr << "  --trips=N         Iterations of every loop, 1-32767 (default 10)" << endl;
+    cerr << "  --mix=CLASS:W,... Instruction mix weights; classes alu, mul, shift," << endl;
+    cerr << "                    load, store, nop (default alu:50,mul:5,shift:10," << endl;
+    cerr << "                    load:20,store:10,nop:5)" << endl;
+    cerr << "  --branches=P      Fraction of body slots that are forward BEQs (default 0.1)" << endl;
+    cerr << "  --dep-distance=D  Sources read the result of the instruction D slots" << endl;
+    cerr << "                    earlier; 0 picks sources at random (default 2)" << endl;
+    cerr << "  --footprint=B     Bytes touched by loads and stores, rounded up to a" << endl;
+    cerr << "                    power of two, 64 to 2^30 (default 4096)" << endl;
+    cerr << "  --seed=N          Random seed (default 1)" << endl;
+    cerr << "  --output=FILE     Write to FILE instead of stdout" << endl;
+    cerr << "  --help, -h        Show this help message" << endl;
+}
+
+enum InstrClass { CLASS_ALU, CLASS_MUL, CLASS_SHIFT, CLASS_LOAD, CLASS_STORE, CLASS_NOP, CLASS_COUNT };
+
+static const char* CLASS_NAMES[CLASS_COUNT] = {"alu", "mul", "shift", "load", "store", "nop"};
+
+// Registers the random instructions compute with. Loop counters live in
+// $s0-$s5, the memory cursor in $s6 and the footprint mask in $s7.
+static const char* WORK_REGS[] = {
+    "$t0", "$t1", "$t2", "$t3", "$t4", "$t5", "$t6", "$t7",
+    "$t8", "$t9", "$a0", "$a1", "$a2", "$a3", "$v0", "$v1",
+};
+static const size_t WORK_COUNT = sizeof(WORK_REGS) / sizeof(WORK_REGS[0]);
+static const int MAX_DEPTH = 6;
+static const uint64_t MEM_WINDOW = 256;   // Bytes addressed from the cursor
+
+struct GenOptions {
+    size_t size = 1000;
+    size_t body = 32;
+    int depth = 2;
+    int trips = 10;
+    unsigned weights[CLASS_COUNT] = {50, 5, 10, 20, 10, 5};
+    double branches = 0.1;
+    size_t depDistance = 2;
+    uint64_t footprint = 4096;
+    uint64_t seed = 1;
+};
+
+// splitmix64: fixed output for a given seed on every platform and standard
+// library, unlike the std::uniform_*_distribution adaptors
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t bound) { return static_cast<size_t>(next() % bound); }
+    double unit() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+class Generator {
+private:
+    const GenOptions& options;
+    Random random;
+    ostream& out;
+    size_t emitted;                 // Static instructions written
+    size_t labels;                  // For unique skip labels
+    vector<size_t> history;         // Destination register of each body slot
+    unsigned totalWeight;
+
+    void emit(const string& text) {
+        out << "        " << text << "\n";
+        emitted++;
+    }
+
+    // First source: the result from depDistance slots back; others random
+    const char* source(bool dependent = true) {
+        size_t d = options.depDistance;
+        if (dependent && d > 0 && history.size() >= d) {
+            return WORK_REGS[history[history.size() - d]];
+        }
+        return WORK_REGS[random.below(WORK_COUNT)];
+    }
+
+    size_t destination() {
+        size_t reg = random.below(WORK_COUNT);
+        history.push_back(reg);
+        return reg;
+    }
+
+    InstrClass pickClass() {
+        size_t roll = random.below(totalWeight);
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            if (roll < options.weights[c]) return static_cast<InstrClass>(c);
+            roll -= options.weights[c];
+        }
+        return CLASS_NOP;
+    }
+
+    // One random instruction of the mix
+    void emitRandom() {
+        static const char* aluOps[] = {"ADD ", "SUB ", "AND ", "OR  "};
+        const size_t window = static_cast<size_t>(min(MEM_WINDOW, options.footprint));
+        ostringstream text;
+
+        switch (pickClass()) {
+            case CLASS_ALU:
+                if (random.below(4) == 0) {
+                    const char* rs = source();
+                    text << "ADDI " << WORK_REGS[destination()] << ", " << rs << ", "
+                         << static_cast<int>(random.below(201)) - 100;
+                } else {
+                    const char* rs = source();
+                    const char* rt = source(false);
+                    text << aluOps[random.below(4)] << " " << WORK_REGS[destination()] << ", "
+                         << rs << ", " << rt;
+                }
+                break;
+            case CLASS_MUL: {
+                const char* rs = source();
+                const char* rt = source(false);
+                text << "MUL  " << WORK_REGS[destination()] << ", " << rs << ", " << rt;
+                break;
+            }
+            case CLASS_SHIFT: {
+                const char* rt = source();
+                text << (random.below(2) ? "SLL  " : "SRL  ") << WORK_REGS[destination()] << ", "
+                     << rt << ", " << random.below(32);
+                break;
+            }
+            case CLASS_LOAD:
+                text << "LW   " << WORK_REGS[destination()] << ", "
+                     << random.below(window / 4) * 4 << "($s6)";
+                break;
+            case CLASS_STORE:
+                text << "SW   " << source() << ", " << random.below(window / 4) * 4 << "($s6)";
+                history.push_back(random.below(WORK_COUNT));
+                break;
+            default:
+                text << "NOP";
+                history.push_back(random.below(WORK_COUNT));
+                break;
+        }
+        emit(text.str());
+    }
+
+    // Innermost body: random instructions with forward branches over 1-3 of
+    // the following slots
+    void emitBody(size_t length) {
+        history.clear();
+        size_t pendingSkip = 0;     // Slots until the open skip label
+        string skipLabel;
+        for (size_t slot = 0; slot < length; slot++) {
+            if (pendingSkip == 0 && slot + 1 < length && random.unit() < options.branches) {
+                skipLabel = "skip" + to_string(labels++);
+                const char* rs = source();
+                const char* rt = source(false);
+                emit("BEQ  " + string(rs) + ", " + string(rt) + ", " + skipLabel);
+                history.push_back(random.below(WORK_COUNT));
+                pendingSkip = 1 + random.below(min<size_t>(3, length - slot - 1));
+                continue;
+            }
+            emitRandom();
+            if (pendingSkip > 0 && --pendingSkip == 0) {
+                out << skipLabel << ":\n";
+            }
+        }
+        if (pendingSkip > 0) {
+            out << skipLabel << ":\n";
+        }
+        // Step the memory cursor to the next window of the footprint
+        emit("ADDI $s6, $s6, " + to_string(min(MEM_WINDOW, options.footprint)));
+        emit("AND  $s6, $s6, $s7");
+    }
+
+    // Returns the dynamic instruction count, not counting skipped slots
+    uint64_t emitNest(size_t nest, int level) {
+        if (level == options.depth) {
+            emitBody(options.body);
+            return options.body + 2;
+        }
+        string name = "n" + to_string(nest) + "_l" + to_string(level);
+        string counter = "$s" + to_string(level);
+        emit("ADDI " + counter + ", $zero, " + to_string(options.trips));
+        out << name << ":\n";
+        uint64_t inner = emitNest(nest, level + 1);
+        emit("ADDI " + counter + ", " + counter + ", -1");
+        emit("BEQ  " + counter + ", $zero, " + name + "_end");
+        emit("J    " + name);
+        out << name << "_end:\n";
+        // The J runs on every trip but the last
+        return 1 + options.trips * (inner + 3) - 1;
+    }
+
+public:
+    Generator(const GenOptions& opts, ostream& output)
+        : options(opts), random(opts.seed), out(output), emitted(0), labels(0), totalWeight(0) {
+        for (int c = 0; c < CLASS_COUNT; c++) totalWeight += options.weights[c];
+    }
+
+    // Returns the estimated dynamic instruction count
+    uint64_t run() {
+        // The cursor steps by one window and is masked with footprint - window
+        // (both powers of two), so cursor + offset never leaves the footprint
+        int bits = 0;
+        while ((uint64_t(1) << bits) < options.footprint) bits++;
+        const uint64_t window = min(MEM_WINDOW, options.footprint);
+        emit("ADDI $s7, $zero, 1");
+        emit("SLL  $s7, $s7, " + to_string(bits));
+        emit("ADDI $s7, $s7, -" + to_string(window));
+        emit("ADDI $s6, $zero, 0");
+
+        // Distinct starting values, so branches and products are not all zero
+        for (size_t reg = 0; reg < WORK_COUNT; reg++) {
+            emit("ADDI " + string(WORK_REGS[reg]) + ", $zero, " +
+                 to_string(static_cast<int>(random.below(2001)) - 1000));
+        }
+
+        uint64_t dynamic = emitted;
+        size_t nest = 0;
+        do {
+            dynamic += emitNest(nest++, 0);
+        } while (emitted < options.size);
+        emit("NOP");
+        return dynamic + 1;
+    }
+
+    size_t instructionCount() const { return emitted; }
+};
+
+static bool parseMix(const string& spec, unsigned weights[CLASS_COUNT]) {
+    for (int c = 0; c < CLASS_COUNT; c++) weights[c] = 0;
+    stringstream items(spec);
+    string item;
+    while (getline(items, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == string::npos) return false;
+        string name = item.substr(0, colon);
+        int c = 0;
+        while (c < CLASS_COUNT && name != CLASS_NAMES[c]) c++;
+        if (c == CLASS_COUNT) return false;
+        weights[c] = static_cast<unsigned>(stoul(item.substr(colon + 1)));
+    }
+    unsigned total = 0;
+    for (int c = 0; c < CLASS_COUNT; c++) total += weights[c];
+    return total > 0;
+}
+
+int main(int argc, char* argv[]) {
+    GenOptions options;
+    string outputPath;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = arg.find('=') == string::npos ? "" : arg.substr(arg.find('=') + 1);
+        try {
+            if (arg.rfind("--size=", 0) == 0) {
+                options.size = stoul(value);
+            } else if (arg.rfind("--body=", 0) == 0) {
+                options.body = stoul(value);
+                if (options.body == 0) throw invalid_argument(arg);
+            } else if (arg.rfind("--depth=", 0) == 0) {
+                options.depth = stoi(value);
+                if (options.depth < 0 || options.depth > MAX_DEPTH) throw invalid_argument(arg);
+            } else if (arg.rfind("--trips=", 0) == 0) {
+                options.trips = stoi(value);
+                if (options.trips < 1 || options.trips > 32767) throw invalid_argument(arg);
+            } else if (arg.rfind("--mix=", 0) == 0) {
+                if (!parseMix(value, options.weights)) throw invalid_argument(arg);
+            } else if (arg.rfind("--branches=", 0) == 0) {
+                options.branches = stod(value);
+                if (!(options.branches >= 0 && options.branches <= 1)) throw invalid_argument(arg);
+            } else if (arg.rfind("--dep-distance=", 0) == 0) {
+                options.depDistance = stoul(value);
+            } else if (arg.rfind("--footprint=", 0) == 0) {
+                options.footprint = stoull(value);
+                if (options.footprint < 64 || options.footprint > (uint64_t(1) << 30)) {
+                    throw invalid_argument(arg);
+                }
+                uint64_t rounded = 64;
+                while (rounded < options.footprint) rounded <<= 1;
+                options.footprint = rounded;
+            } else if (arg.rfind("--seed=", 0) == 0) {
+                options.seed = stoull(value);
+            } else if (arg.rfind("--output=", 0) == 0) {
+                outputPath = value;
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else {
+                cerr << "Unknown option: " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            cerr << "Invalid value: " << arg << endl;
+            return 1;
+        }
+    }
+
+    ofstream outputFile;
+    if (!outputPath.empty()) {
+        outputFile.open(outputPath);
+        if (!outputFile) {
+            cerr << "Error: Could not create '" << outputPath << "'" << endl;
+            return 1;
+        }
+    }
+    ostream& out = outputPath.empty() ? cout : outputFile;
+
+    // The header records every knob, so the file can be regenerated
+    out << "# Generated by mips_gen: --size=" << options.size << " --body=" << options.body
+        << " --depth=" << options.depth << " --trips=" << options.trips << " --mix=";
+    for (int c = 0; c < CLASS_COUNT; c++) {
+        out << (c ? "," : "") << CLASS_NAMES[c] << ":" << options.weights[c];
+    }
+    out << "\n# --branches=" << options.branches << " --dep-distance=" << options.depDistance
+        << " --footprint=" << options.footprint << " --seed=" << options.seed << "\n";
+
+    Generator generator(options, out);
+    uint64_t dynamic = generator.run();
+    out.flush();
+    if (!out) {
+        cerr << "Error: Could not write output" << endl;
+        return 1;
+    }
+    cerr << "Generated " << generator.instructionCount() << " instructions (about "
+         << dynamic << " executed)" << endl;
+    return 0;
+}
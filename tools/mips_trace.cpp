@@ -0,0 +1,272 @@
+#include "../include/trace.h"
+#include "../include/cpu.h"
+#include "../include/debug.h"
+#include "../include/errors.h"
+#include "../include/parser.h"
+#include "../include/binloader.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// mips_trace: offline decoder for the binary traces written by mips_sim --trace.
+// Decodes, filters and pretty-prints records, or summarizes the whole run.
+
+void printUsage(const char* progName) {
+    cerr << "MIPS Trace Decoder - CS3339 Fall 2025" << endl << endl;
+    cerr << "Usage: " << progName << " <trace.bin> [options]" << endl << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --program=FILE Annotate retired instructions with their source text" << endl;
+    cerr << "                 (the .asm, object or ELF file that was traced)" << endl;
+    cerr << "  --from=C       Skip records before cycle C" << endl;
+    cerr << "  --to=C         Stop after cycle C" << endl;
+    cerr << "  --pc=N         Only records with instruction N in some stage" << endl;
+    cerr << "  --reg=R        Only writes to register R ($t0 or 8)" << endl;
+    cerr << "  --mem=ADDR     Only loads and stores to byte address ADDR" << endl;
+    cerr << "  --branches     Only records that resolve a branch or jump" << endl;
+    cerr << "  --mispredicts  Only records with a branch misprediction" << endl;
+    cerr << "  --limit=N      Print at most N records" << endl;
+    cerr << "  --summary      Print totals instead of records" << endl;
+    cerr << "  --help, -h     Show this help message" << endl;
+}
+
+struct TraceFilter {
+    uint64_t from;
+    uint64_t to;
+    long pc;            // -1 = any
+    int reg;            // -1 = any
+    long long mem;      // -1 = any
+    bool branches;
+    bool mispredicts;
+
+    TraceFilter() : from(0), to(UINT64_MAX), pc(-1), reg(-1), mem(-1),
+                    branches(false), mispredicts(false) {}
+
+    bool matches(const TraceRecord& record) const {
+        if (record.cycle < from || record.cycle > to) return false;
+        if (pc >= 0) {
+            bool found = (record.flags & TRACE_BRANCH) && record.branchPc == static_cast<uint32_t>(pc);
+            for (int stage = 0; stage < TRACE_STAGES && !found; stage++) {
+                found = record.hasStage(stage) && record.stagePc[stage] == static_cast<uint32_t>(pc);
+            }
+            if (!found) return false;
+        }
+        if (reg >= 0 && (!(record.flags & TRACE_REG_WRITE) || record.reg != reg)) return false;
+        if (mem >= 0 && (!(record.flags & (TRACE_MEM_READ | TRACE_MEM_WRITE)) ||
+                         record.memAddress != static_cast<uint32_t>(mem))) return false;
+        if (branches && !(record.flags & TRACE_BRANCH)) return false;
+        if (mispredicts && !(record.flags & TRACE_MISPREDICT)) return false;
+        return true;
+    }
+};
+
+struct TraceSummary {
+    uint64_t records = 0;
+    uint64_t firstCycle = 0;
+    uint64_t lastCycle = 0;
+    uint64_t retired = 0;
+    uint64_t regWrites = 0;
+    uint64_t loads = 0;
+    uint64_t stores = 0;
+    uint64_t branches = 0;
+    uint64_t taken = 0;
+    uint64_t mispredicts = 0;
+    uint64_t stalls = 0;
+
+    void add(const TraceRecord& record) {
+        if (records++ == 0) firstCycle = record.cycle;
+        lastCycle = record.cycle;
+        if (record.hasStage(TRACE_WB)) retired++;
+        if (record.flags & TRACE_REG_WRITE) regWrites++;
+        if (record.flags & TRACE_MEM_READ) loads++;
+        if (record.flags & TRACE_MEM_WRITE) stores++;
+        if (record.flags & TRACE_BRANCH) branches++;
+        if (record.flags & TRACE_TAKEN) taken++;
+        if (record.flags & TRACE_MISPREDICT) mispredicts++;
+        if (record.flags & TRACE_STALL) stalls++;
+    }
+};
+
+static int parseRegister(const string& text) {
+    for (int reg = 0; reg < 32; reg++) {
+        if (text == Debug::regName(reg) || text == "$" + to_string(reg)) return reg;
+    }
+    try {
+        size_t used = 0;
+        int reg = stoi(text, &used);
+        if (used == text.size() && reg >= 0 && reg < 32) return reg;
+    } catch (...) {
+    }
+    return -1;
+}
+
+static string stagePc(const TraceRecord& record, int stage) {
+    return record.hasStage(stage) ? to_string(record.stagePc[stage]) : "-";
+}
+
+static void printRecord(const TraceRecord& record, bool pipeline, const Program* program) {
+    ostringstream line;
+    line << setw(10) << record.cycle;
+    if (pipeline) {
+        static const char* names[TRACE_STAGES] = {"IF", "ID", "EX", "MEM", "WB"};
+        for (int stage = 0; stage < TRACE_STAGES; stage++) {
+            line << "  " << names[stage] << " " << left << setw(5) << stagePc(record, stage) << right;
+        }
+    } else {
+        line << "  PC " << left << setw(6) << stagePc(record, TRACE_WB) << right;
+    }
+
+    if (record.flags & TRACE_STALL) {
+        line << "  dcache-stall";
+    }
+    if (record.flags & TRACE_REG_WRITE) {
+        line << "  " << Debug::regName(record.reg) << "=" << record.regValue;
+    }
+    if (record.flags & TRACE_MEM_READ) {
+        line << "  LW [" << record.memAddress << "]=" << record.memValue;
+    } else if (record.flags & TRACE_MEM_WRITE) {
+        line << "  SW [" << record.memAddress << "]=" << record.memValue;
+    }
+    if (record.flags & TRACE_BRANCH) {
+        line << "  branch@" << record.branchPc << ((record.flags & TRACE_TAKEN) ? " taken" : " not-taken");
+        if (record.flags & TRACE_MISPREDICT) line << " mispredicted";
+    }
+    if (program && record.hasStage(TRACE_WB)) {
+        line << "  | " << Debug::sourceText(program->source, record.stagePc[TRACE_WB]);
+    }
+    cout << line.str() << "\n";
+}
+
+static void printSummary(const TraceSummary& summary, const TraceReader& reader) {
+    cout << "=== TRACE SUMMARY ===" << endl;
+    cout << "Engine:        " << execModeToString(static_cast<ExecMode>(reader.getHeader().mode)) << endl;
+    cout << "Program size:  " << reader.getHeader().programSize << " instructions" << endl;
+    cout << "Records:       " << summary.records << endl;
+    if (summary.records > 0) {
+        cout << "Cycles:        " << summary.firstCycle << " - " << summary.lastCycle << endl;
+    }
+    cout << "Retired:       " << summary.retired << endl;
+    cout << "Reg writes:    " << summary.regWrites << endl;
+    cout << "Loads:         " << summary.loads << endl;
+    cout << "Stores:        " << summary.stores << endl;
+    cout << "Branches:      " << summary.branches << " (" << summary.taken << " taken, "
+         << summary.mispredicts << " mispredicted)" << endl;
+    cout << "D-cache stalls: " << summary.stalls << endl;
+    if (summary.records > 0) {
+        cout << "Bytes/record:  " << fixed << setprecision(2)
+             << double(reader.size() - sizeof(TraceHeader)) / summary.records << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    string tracePath;
+    string programPath;
+    TraceFilter filter;
+    uint64_t limit = UINT64_MAX;
+    bool summaryOnly = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        try {
+            if (arg.rfind("--program=", 0) == 0) {
+                programPath = arg.substr(10);
+            } else if (arg.rfind("--from=", 0) == 0) {
+                filter.from = stoull(arg.substr(7));
+            } else if (arg.rfind("--to=", 0) == 0) {
+                filter.to = stoull(arg.substr(5));
+            } else if (arg.rfind("--pc=", 0) == 0) {
+                filter.pc = stol(arg.substr(5));
+            } else if (arg.rfind("--reg=", 0) == 0) {
+                filter.reg = parseRegister(arg.substr(6));
+                if (filter.reg < 0) {
+                    cerr << "Invalid register: " << arg.substr(6) << endl;
+                    return 1;
+                }
+            } else if (arg.rfind("--mem=", 0) == 0) {
+                filter.mem = stoll(arg.substr(6), nullptr, 0);
+            } else if (arg == "--branches") {
+                filter.branches = true;
+            } else if (arg == "--mispredicts") {
+                filter.mispredicts = true;
+            } else if (arg.rfind("--limit=", 0) == 0) {
+                limit = stoull(arg.substr(8));
+            } else if (arg == "--summary") {
+                summaryOnly = true;
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else if (!arg.empty() && arg[0] == '-') {
+                cerr << "Unknown option: " << arg << endl;
+                printUsage(argv[0]);
+                return 1;
+            } else {
+                tracePath = arg;
+            }
+        } catch (...) {
+            cerr << "Invalid value: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (tracePath.empty()) {
+        cerr << "Error: No trace file specified" << endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        TraceReader reader;
+        reader.open(tracePath);
+
+        // Source text for annotation comes from the same loaders mips_sim uses
+        Program program;
+        bool haveProgram = false;
+        if (!programPath.empty()) {
+            MappedFile file;
+            if (!file.open(programPath)) {
+                cerr << "Error: Could not open file '" << programPath << "'" << endl;
+                return 1;
+            }
+            // The trace already ran, so a delay slot is no reason to refuse
+            if (!BinaryLoader::loadPrebuilt(file, false, ByteOrder::BIG, program, true)) {
+                ErrorHandler errorHandler;
+                Parser parser(errorHandler);
+                program = parser.parse(file.text());
+                if (errorHandler.hasErrors()) {
+                    errorHandler.printErrors();
+                    return 1;
+                }
+            }
+            haveProgram = true;
+        }
+
+        bool pipeline = static_cast<ExecMode>(reader.getHeader().mode) == ExecMode::PIPELINE;
+        TraceSummary summary;
+        uint64_t printed = 0;
+        TraceRecord record;
+        while (reader.next(record)) {
+            if (record.cycle > filter.to) break;
+            if (!filter.matches(record)) continue;
+            summary.add(record);
+            if (!summaryOnly) {
+                if (printed++ >= limit) break;
+                printRecord(record, pipeline, haveProgram ? &program : nullptr);
+            }
+        }
+
+        if (summaryOnly) {
+            printSummary(summary, reader);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}